@@ -0,0 +1,199 @@
+#include "ClockSampler.hpp"
+#include <sys/syscall.h>
+#include <ppu_intrinsics.h>
+#include <cell/atomic.h>
+
+ClockSampler::ClockSampler(PeekFunction peek)
+	: m_Peek(peek)
+{
+	m_Reading.GetBuffer(0) = { 0, 0, CLOCK_STANDARD };
+	m_Reading.GetBuffer(1) = m_Reading.GetBuffer(0);
+}
+
+__attribute__((noinline)) uint64_t ClockSampler::PeekLv1(uint64_t address)
+{
+	system_call_1(8, address);
+	return_to_user_prog(uint64_t);
+}
+
+ClockState ClockSampler::Classify(uint32_t core_MHz, uint32_t vram_MHz)
+{
+	if (core_MHz == 0 || vram_MHz == 0)
+		return CLOCK_ERROR;
+
+	if ((core_MHz > 500 && vram_MHz < 650) || (core_MHz < 500 && vram_MHz > 650))
+		return CLOCK_BALANCED;
+
+	if (core_MHz > 500 || vram_MHz > 650)
+		return CLOCK_OVERCLOCK;
+
+	if (core_MHz == 500 && vram_MHz == 650)
+		return CLOCK_STANDARD;
+
+	return CLOCK_UNDERCLOCK;
+}
+
+bool ClockSampler::Update(uint64_t now_us)
+{
+	// whoever loses the race just doesn't sample, the winner's reading serves both
+	if (cellAtomicCompareAndSwap32(&m_UpdateLock, 0, 1) != 0)
+		return false;
+
+	bool sampled = UpdateLocked(now_us);
+	__lwsync();
+	m_UpdateLock = 0;
+	return sampled;
+}
+
+bool ClockSampler::UpdateLocked(uint64_t now_us)
+{
+	if (m_TightenRequested)
+	{
+		m_TightenRequested = false;
+		m_Interval_us = MinInterval_us;
+		m_NextSample_us = now_us;
+	}
+
+	if (m_HasReading && now_us < m_NextSample_us)
+		return false;
+
+	ClockReading reading = Sample(now_us);
+	if (!m_HasReading)
+	{
+		// nothing to hold the first one against
+		m_HasReading = true;
+		Publish(reading, now_us);
+	}
+	else if (Equals(reading, *m_Reading.Get()))
+	{
+		if (m_CandidateCount)
+			m_RejectedCount++;
+		m_CandidateCount = 0;
+
+		m_Interval_us = m_Interval_us * 2 > MaxInterval_us ? MaxInterval_us : m_Interval_us * 2;
+	}
+	else
+	{
+		if (m_CandidateCount && Equals(reading, m_Candidate))
+		{
+			m_CandidateCount++;
+		}
+		else
+		{
+			if (m_CandidateCount)
+				m_RejectedCount++;
+			m_Candidate = reading;
+			m_CandidateCount = 1;
+		}
+
+		if (m_CandidateCount >= ConfirmSamples)
+		{
+			m_CandidateCount = 0;
+			Publish(reading, now_us);
+		}
+
+		// confirm or dismiss it quickly either way
+		m_Interval_us = MinInterval_us;
+	}
+
+	m_NextSample_us = now_us + m_Interval_us;
+	return true;
+}
+
+size_t ClockSampler::GetRecentSamples(ClockSample* samples, size_t count) const
+{
+	size_t copied = 0;
+	for (uint32_t age = 0; copied < count && m_History.Read(age, samples[copied]); age++)
+		copied++;
+	return copied;
+}
+
+bool ClockSampler::GetWindowStats(uint64_t now_us, uint64_t window_us, ClockWindowStats& stats) const
+{
+	stats = ClockWindowStats{};
+	stats.coreMin_MHz = stats.vramMin_MHz = ~0u;
+
+	uint64_t start_us = now_us > window_us ? now_us - window_us : 0;
+	uint64_t end_us = now_us;  // when the sample being looked at stopped holding
+	uint64_t coreSum = 0, vramSum = 0, weightSum = 0;
+
+	ClockSample sample;
+	for (uint32_t age = 0; end_us > start_us && m_History.Read(age, sample); age++)
+	{
+		// the oldest sample inside the window still counts from the window's start
+		uint64_t from_us = sample.time_us > start_us ? sample.time_us : start_us;
+		uint64_t weight = end_us > from_us ? end_us - from_us : 0;
+		end_us = sample.time_us;
+
+		const ClockReading& reading = sample.reading;
+		if (reading.state == CLOCK_ERROR)
+			continue;
+
+		stats.samples++;
+		stats.coreMin_MHz = reading.core_MHz < stats.coreMin_MHz ? reading.core_MHz : stats.coreMin_MHz;
+		stats.coreMax_MHz = reading.core_MHz > stats.coreMax_MHz ? reading.core_MHz : stats.coreMax_MHz;
+		stats.vramMin_MHz = reading.vram_MHz < stats.vramMin_MHz ? reading.vram_MHz : stats.vramMin_MHz;
+		stats.vramMax_MHz = reading.vram_MHz > stats.vramMax_MHz ? reading.vram_MHz : stats.vramMax_MHz;
+
+		// a sample taken right at `now` holds for no time yet, it still needs a say in the average
+		if (weight == 0)
+			weight = 1;
+		coreSum += reading.core_MHz * weight;
+		vramSum += reading.vram_MHz * weight;
+		weightSum += weight;
+	}
+
+	if (!stats.samples)
+	{
+		stats.coreMin_MHz = stats.vramMin_MHz = 0;
+		return false;
+	}
+
+	stats.coreAvg_MHz = static_cast<uint32_t>((coreSum + weightSum / 2) / weightSum);
+	stats.vramAvg_MHz = static_cast<uint32_t>((vramSum + weightSum / 2) / weightSum);
+	return true;
+}
+
+bool ClockSampler::GetTimeSinceChange(uint64_t now_us, uint64_t& elapsed_us) const
+{
+	uint64_t lastChange_us = m_LastChange_us;
+	if (!lastChange_us)
+		return false;
+
+	elapsed_us = now_us > lastChange_us ? now_us - lastChange_us : 0;
+	return true;
+}
+
+ClockReading ClockSampler::Sample(uint64_t now_us)
+{
+	constexpr uint64_t GPU_CORE_CLOCK = 0x28000004028;
+	constexpr uint64_t GPU_VRAM_CLOCK = 0x28000004010;
+
+	auto readMultiplier = [this](uint64_t address) -> uint32_t {
+		union {
+			struct { uint32_t junk0; uint8_t junk1, junk2, mul, junk3; };
+			uint64_t value;
+		} clock{};
+		clock.value = m_Peek(address);
+		m_PeekCount++;
+		return clock.mul;
+	};
+
+	ClockReading reading;
+	reading.core_MHz = readMultiplier(GPU_CORE_CLOCK) * 50;
+	reading.vram_MHz = readMultiplier(GPU_VRAM_CLOCK) * 25;
+	reading.state = Classify(reading.core_MHz, reading.vram_MHz);
+	m_SampleCount++;
+
+	ClockSample sample = { now_us, reading };
+	m_History.Push(sample);
+	return reading;
+}
+
+void ClockSampler::Publish(const ClockReading& reading, uint64_t now_us)
+{
+	if (!Equals(reading, *m_Reading.Get()) || !m_LastChange_us)
+		m_LastChange_us = now_us ? now_us : 1;
+
+	m_Reading.Publish(reading);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "DoubleBuffer.hpp"
+#include "SeqlockRing.hpp"
+
+enum ClockState
+{
+	CLOCK_OVERCLOCK,
+	CLOCK_STANDARD,
+	CLOCK_UNDERCLOCK,
+	CLOCK_BALANCED,
+	CLOCK_ERROR
+};
+
+struct ClockReading
+{
+	uint32_t core_MHz;   // 0 when the peek came back empty
+	uint32_t vram_MHz;
+	ClockState state;
+};
+
+struct ClockSample
+{
+	uint64_t time_us;
+	ClockReading reading;
+};
+
+// over the samples that read back, CLOCK_ERROR ones are left out; averages are weighted by how long each
+// reading held, since the sampling interval isn't fixed
+struct ClockWindowStats
+{
+	uint32_t samples;
+	uint32_t coreMin_MHz, coreMax_MHz, coreAvg_MHz;
+	uint32_t vramMin_MHz, vramMax_MHz, vramAvg_MHz;
+};
+
+// Owns the RSX clock peeks: raw core and VRAM frequencies plus the state they classify as.
+// The interval doubles from MinInterval_us up to MaxInterval_us for as long as the readings stay the same,
+// and drops back to the minimum after a change or a Tighten(). A reading that differs from the published
+// one has to repeat ConfirmSamples times in a row before it's published, so one odd peek can't flip the logo.
+// Every sample, odd ones included, also goes into a HistorySize deep ring that any thread can query.
+// Update() can be called from more than one thread, a caller that finds another one sampling just skips.
+// The published reading and the history can be read from any thread, draw hook included: reading never
+// allocates or locks.
+// Times are on whatever clock Update() is fed, the queries expect `now` on the same one.
+class ClockSampler
+{
+public:
+	typedef uint64_t(*PeekFunction)(uint64_t address);
+
+	static constexpr uint64_t MinInterval_us = 1000000;
+	static constexpr uint64_t MaxInterval_us = 32000000;
+	static constexpr uint32_t ConfirmSamples = 2;
+	static constexpr size_t HistorySize = 64;
+
+	// `peek` reads one lv1 word, the hypervisor peek unless something else is scripted in
+	explicit ClockSampler(PeekFunction peek = PeekLv1);
+
+	// samples when the interval is up, true when it did
+	bool Update(uint64_t now_us);
+
+	// a reading that differs from the published one is waiting for the samples that confirm it
+	bool IsConfirming() const { return m_CandidateCount != 0; }
+
+	// the next Update() samples right away and the interval starts over, safe from any thread
+	void Tighten() { m_TightenRequested = true; }
+
+	static ClockState Classify(uint32_t core_MHz, uint32_t vram_MHz);
+	static uint64_t PeekLv1(uint64_t address);
+
+	// CLOCK_STANDARD with 0 MHz until the first sample
+	ClockReading GetReading() const { return m_Reading.Read(); }
+	ClockState GetState() const { return m_Reading.Get()->state; }
+	uint32_t GetCoreMHz() const { return m_Reading.Get()->core_MHz; }
+	uint32_t GetVramMHz() const { return m_Reading.Get()->vram_MHz; }
+
+	uint64_t GetPeekCount() const { return m_PeekCount; }
+	uint32_t GetSampleCount() const { return m_SampleCount; }
+	uint32_t GetRejectedCount() const { return m_RejectedCount; }
+	uint64_t GetInterval() const { return m_Interval_us; }
+
+	// up to `count` samples into `samples`, newest first, returns how many were copied
+	size_t GetRecentSamples(ClockSample* samples, size_t count) const;
+
+	// the samples taken in the last `window_us`, false when there were none worth counting
+	bool GetWindowStats(uint64_t now_us, uint64_t window_us, ClockWindowStats& stats) const;
+
+	// time since the published reading last changed, false before the first sample
+	bool GetTimeSinceChange(uint64_t now_us, uint64_t& elapsed_us) const;
+
+private:
+	bool UpdateLocked(uint64_t now_us);
+	ClockReading Sample(uint64_t now_us);
+	void Publish(const ClockReading& reading, uint64_t now_us);
+
+	static bool Equals(const ClockReading& a, const ClockReading& b)
+	{
+		return a.core_MHz == b.core_MHz && a.vram_MHz == b.vram_MHz && a.state == b.state;
+	}
+
+private:
+	PeekFunction m_Peek;
+	uint32_t m_UpdateLock = 0;
+	DoubleBuffer<ClockReading> m_Reading;
+
+	ClockReading m_Candidate{};        // differs from the published reading, waiting to be confirmed
+	uint32_t m_CandidateCount = 0;
+	bool m_HasReading = false;
+	volatile bool m_TightenRequested = false;
+	uint64_t m_NextSample_us = 0;
+	uint64_t m_Interval_us = MinInterval_us;
+	volatile uint64_t m_LastChange_us = 0;
+
+	SeqlockRing<ClockSample, HistorySize> m_History;
+
+	volatile uint64_t m_PeekCount = 0;
+	volatile uint32_t m_SampleCount = 0;
+	volatile uint32_t m_RejectedCount = 0; // readings dropped because they never repeated
+};
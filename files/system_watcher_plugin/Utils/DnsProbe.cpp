@@ -0,0 +1,36 @@
+#include "DnsProbe.hpp"
+#include <sys/socket.h>
+
+bool DnsProbe::IsRoutableAddress(uint32_t address)
+{
+	uint32_t first = address >> 24, second = (address >> 16) & 0xFF;
+	return first != 0 && first != 10 && first != 127 && !(first == 192 && second == 168) && !(first == 172 && (second & 0xF0) == 16);
+}
+
+DnsProbe::Result DnsProbe::Run(const char* const* hosts, size_t hostCount, ResolveFunction resolve, const ServerTable& table)
+{
+	Result result{ nullptr, 0 };
+	for (size_t i = 0; i < hostCount; i++)
+	{
+		hostent* entry = resolve(hosts[i]);
+		if (!entry || entry->h_addrtype != AF_INET || !entry->h_addr_list)
+			continue;
+
+		for (char** answer = entry->h_addr_list; *answer; answer++)
+		{
+			// network order, spelled out so it reads the same on any host
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(*answer);
+			uint32_t value = (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+			if (!IsRoutableAddress(value))
+				continue;
+
+			if (const wchar_t* name = table.FindByRange(value))
+				return Result{ name, value };
+
+			if (!result.address)
+				result.address = value;
+		}
+	}
+
+	return result;
+}
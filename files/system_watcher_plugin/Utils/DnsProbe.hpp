@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netdb.h>
+#include "ServerTable.hpp"
+
+// What the answers for a few PSN hostnames say about the network: a revival server answers with its own
+// hosts, listed as ranges in the server table, where PSN answers with Sony's. The resolver is passed in, the
+// real gethostbyname() unless something else is scripted in; it may block as long as it likes, and one
+// that has been told to stop simply answers nothing for the remaining hosts.
+namespace DnsProbe
+{
+	typedef hostent* (*ResolveFunction)(const char* host);
+
+	struct Result
+	{
+		const wchar_t* name;   // server table entry, nullptr when the answers looked like PSN
+		uint32_t address;      // the answer that matched, else the first routable one, 0 when nothing usable came back
+	};
+
+	// loopback, unspecified and private answers come from a blocklist or a captive portal, not from a server
+	bool IsRoutableAddress(uint32_t address);
+
+	// resolves `hosts` in order and stops at the first answer inside one of the table's ranges
+	Result Run(const char* const* hosts, size_t hostCount, ResolveFunction resolve, const ServerTable& table);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ppu_intrinsics.h>
+
+// A value one thread publishes and any number of others read without locks. The writer fills in the
+// buffer readers aren't looking at, then swings the pointer to it; the store barrier in between makes sure
+// nobody sees the pointer before the contents.
+// A pointer from Get() stays valid until the second Publish() after it was taken, which is plenty for a
+// reader that publishes are rare next to. One that can be overtaken takes a Read() copy instead.
+// Publishes have to be serialised by the caller: a single writer thread, or a lock around them.
+template<typename T>
+class DoubleBuffer
+{
+public:
+	// the latest published value, a value-initialised one before the first Publish()
+	const T* Get() const { return m_Current; }
+
+	// a copy no publish has torn, retried if one landed while copying
+	T Read() const
+	{
+		for (;;)
+		{
+			uint32_t serial = m_Serial;
+			__lwsync();
+			T copy = *m_Current;
+			__lwsync();
+			if (serial == m_Serial)
+				return copy;
+		}
+	}
+
+	// the buffer the next Publish() makes current, writer only. Filling it in place saves a copy, and
+	// members with reserved storage keep it
+	T& Next() { return m_Buffers[m_Current == &m_Buffers[0] ? 1 : 0]; }
+
+	const T* Publish()
+	{
+		const T* next = &Next();
+		__lwsync();
+		m_Current = next;
+		m_Serial = m_Serial + 1;
+		__lwsync();
+		return next;
+	}
+
+	const T* Publish(const T& value)
+	{
+		Next() = value;
+		return Publish();
+	}
+
+	// for setup that has to touch both buffers before anything is published
+	T& GetBuffer(size_t index) { return m_Buffers[index & 1]; }
+
+private:
+	T m_Buffers[2]{};
+	const T* volatile m_Current = &m_Buffers[0];
+	volatile uint32_t m_Serial = 0;
+};
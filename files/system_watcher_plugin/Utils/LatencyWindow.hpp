@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+
+// Rolling window over the last `Size` probes of a target, replies and losses alike, with a histogram of
+// the replies kept up to date as samples come and go. Jitter is the RFC 3550 running estimate over
+// consecutive replies, so a single lost probe doesn't reset it.
+template<size_t Size>
+class LatencyWindow
+{
+public:
+	static constexpr size_t BucketCount = 6;
+	static constexpr uint32_t Lost = ~0u;
+
+	LatencyWindow() = default;
+
+	void Clear()
+	{
+		m_Count = 0;
+		m_Next = 0;
+		m_Losses = 0;
+		m_Jitter_us = 0;
+		m_LastReply_us = Lost;
+		for (size_t i = 0; i < BucketCount; i++)
+			m_Buckets[i] = 0;
+	}
+
+	void AddReply(uint32_t rtt_us)
+	{
+		if (rtt_us == Lost)
+			rtt_us = Lost - 1;
+
+		if (m_LastReply_us != Lost)
+		{
+			uint32_t delta = rtt_us > m_LastReply_us ? rtt_us - m_LastReply_us : m_LastReply_us - rtt_us;
+			m_Jitter_us = static_cast<uint32_t>(static_cast<int64_t>(m_Jitter_us) + (static_cast<int64_t>(delta) - m_Jitter_us) / 16);
+		}
+
+		m_LastReply_us = rtt_us;
+		m_Buckets[BucketOf(rtt_us)]++;
+		Push(rtt_us);
+	}
+
+	void AddLoss()
+	{
+		m_Losses++;
+		Push(Lost);
+	}
+
+	size_t GetCount() const { return m_Count; }
+	size_t GetReplyCount() const { return m_Count - m_Losses; }
+	uint32_t GetLossPercent() const { return m_Count ? static_cast<uint32_t>(m_Losses * 100 / m_Count) : 0; }
+	uint32_t GetJitter() const { return m_Jitter_us; }
+
+	// replies under 25, 50, 100, 200 and 400 ms, then everything slower
+	uint32_t GetBucket(size_t index) const { return m_Buckets[index]; }
+
+	// median of the replies in the window (the lower one of an even count), false when there are none
+	bool GetMedian(uint32_t& rtt_us) const
+	{
+		uint32_t replies[Size];
+		size_t count = 0;
+		for (size_t i = 0; i < m_Count; i++)
+		{
+			if (m_Samples[i] != Lost)
+				replies[count++] = m_Samples[i];
+		}
+
+		if (count == 0)
+			return false;
+
+		std::nth_element(replies, replies + (count - 1) / 2, replies + count);
+		rtt_us = replies[(count - 1) / 2];
+		return true;
+	}
+
+private:
+	static size_t BucketOf(uint32_t rtt_us)
+	{
+		size_t bucket = 0;
+		for (uint32_t limit_us = 25000; bucket < BucketCount - 1 && rtt_us >= limit_us; limit_us *= 2)
+			bucket++;
+		return bucket;
+	}
+
+	void Push(uint32_t sample)
+	{
+		if (m_Count == Size)
+		{
+			uint32_t evicted = m_Samples[m_Next];
+			if (evicted == Lost)
+				m_Losses--;
+			else
+				m_Buckets[BucketOf(evicted)]--;
+		}
+		else
+		{
+			m_Count++;
+		}
+
+		m_Samples[m_Next] = sample;
+		m_Next = (m_Next + 1) % Size;
+	}
+
+private:
+	uint32_t m_Samples[Size]{};
+	uint32_t m_Buckets[BucketCount]{};
+	size_t m_Count = 0;
+	size_t m_Next = 0;
+	size_t m_Losses = 0;
+	uint32_t m_Jitter_us = 0;
+	uint32_t m_LastReply_us = Lost;
+};
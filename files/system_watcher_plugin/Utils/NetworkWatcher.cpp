@@ -0,0 +1,48 @@
+#include "NetworkWatcher.hpp"
+
+bool NetworkWatcher::Start()
+{
+	if (m_HandlerId >= 0)
+		return true;
+
+	if (m_AddHandler(HandleEvent, this, &m_HandlerId) < 0)
+		m_HandlerId = -1;
+	return m_HandlerId >= 0;
+}
+
+void NetworkWatcher::Stop()
+{
+	if (m_HandlerId >= 0)
+		m_DelHandler(m_HandlerId);
+	m_HandlerId = -1;
+}
+
+void NetworkWatcher::Poll()
+{
+	if (m_HandlerId >= 0)
+		return;
+
+	int state = CELL_NET_CTL_STATE_Disconnected;
+	if (m_GetState(&state) < 0)
+		return;
+
+	if (state != m_PolledState)
+	{
+		m_PolledState = state;
+		m_Serial = m_Serial + 1;
+	}
+}
+
+void NetworkWatcher::OnEvent(int prevState, int newState, int event)
+{
+	// connect requests and handshakes don't change what we display, only the outcome does. An error may
+	// have cost the address without netctl reporting a transition
+	if (event == CELL_NET_CTL_EVENT_GET_IP || event == CELL_NET_CTL_EVENT_DISCONNECT_REQ || event == CELL_NET_CTL_EVENT_ERROR ||
+		event == CELL_NET_CTL_EVENT_LINK_DISCONNECTED || prevState != newState)
+		m_Serial = m_Serial + 1;
+}
+
+void NetworkWatcher::HandleEvent(int prevState, int newState, int event, int /*errorCode*/, void* arg)
+{
+	static_cast<NetworkWatcher*>(arg)->OnEvent(prevState, newState, event);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <cell/netctl.h>
+
+// Turns netctl's connect, disconnect and new-IP notifications into a serial that only moves when what the
+// IP text shows could have changed, so the publisher regenerates on a new serial instead of on a timer.
+// The preferred source is a netctl handler. If it can't be registered, Poll() reads the netctl state word
+// instead, a single cheap call, and treats any state change as an event.
+// The netctl calls are passed in, the real ones unless something else is scripted in. States and events are
+// the SDK's CELL_NET_CTL_STATE_* and CELL_NET_CTL_EVENT_* values.
+// Start(), Stop() and Poll() belong to one thread; the handler runs on netctl's and GetSerial() on any.
+class NetworkWatcher
+{
+public:
+	typedef void(*Handler)(int prevState, int newState, int event, int errorCode, void* arg);
+	typedef int(*AddHandlerFunction)(Handler handler, void* arg, int* handlerId);
+	typedef int(*DelHandlerFunction)(int handlerId);
+	typedef int(*GetStateFunction)(int* state);
+
+	NetworkWatcher(AddHandlerFunction addHandler, DelHandlerFunction delHandler, GetStateFunction getState)
+		: m_AddHandler(addHandler), m_DelHandler(delHandler), m_GetState(getState) {}
+
+	// false when the handler couldn't be registered and Poll() has to do the work
+	bool Start();
+	void Stop();
+
+	// once per watcher pass, does nothing while the handler is registered
+	void Poll();
+
+	bool IsPolling() const { return m_HandlerId < 0; }
+
+	// starts ahead of any reader's copy, so the first pass always generates
+	uint32_t GetSerial() const { return m_Serial; }
+
+	// what the handler does with a notification, public so a stand-in netctl can drive it directly
+	void OnEvent(int prevState, int newState, int event);
+
+private:
+	static void HandleEvent(int prevState, int newState, int event, int errorCode, void* arg);
+
+private:
+	AddHandlerFunction m_AddHandler;
+	DelHandlerFunction m_DelHandler;
+	GetStateFunction m_GetState;
+
+	volatile uint32_t m_Serial = 1;
+	int m_HandlerId = -1;
+	int m_PolledState = -1;
+};
@@ -0,0 +1,98 @@
+#include "PingProbe.hpp"
+#include <sys/sys_time.h>
+#include <sys/socket.h>
+#include <sys/poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netex/errno.h>
+
+PingResult MeasureConnectRtt(const PingTarget& target, int32_t timeout_ms, uint32_t& rtt_us)
+{
+	int s = socket(AF_INET, SOCK_STREAM, 0);
+	if (s < 0)
+		return PING_FAILED;
+
+	int nonBlocking = 1;
+	if (setsockopt(s, SOL_SOCKET, SO_NBIO, &nonBlocking, sizeof(nonBlocking)) < 0)
+	{
+		socketclose(s);
+		return PING_FAILED;
+	}
+
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(target.port);
+	address.sin_addr.s_addr = htonl(target.address);
+
+	uint64_t start_us = sys_time_get_system_time();
+	PingResult result = PING_REPLY;
+	if (connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		pollfd fd{ s, POLLOUT, 0 };
+		if (socketpoll(&fd, 1, timeout_ms) <= 0)
+			result = PING_LOST;
+		else
+		{
+			int error = 0;
+			socklen_t length = sizeof(error);
+			getsockopt(s, SOL_SOCKET, SO_ERROR, &error, &length);
+
+			bool connected = error == 0 && (fd.revents & POLLOUT) && !(fd.revents & (POLLERR | POLLHUP));
+			if (!connected && error != SYS_NET_ECONNREFUSED)
+				result = PING_LOST;
+		}
+	}
+
+	rtt_us = static_cast<uint32_t>(sys_time_get_system_time() - start_us);
+	socketclose(s);
+	return result;
+}
+
+void PingProbe::Publish(uint64_t target)
+{
+	PingSummary summary{ target, static_cast<uint32_t>(m_Window.GetReplyCount()), 0,
+		(m_Window.GetJitter() + 500) / 1000, m_Window.GetLossPercent() };
+
+	uint32_t median_us;
+	if (m_Window.GetMedian(median_us))
+		summary.median_ms = (median_us + 500) / 1000;
+
+	// every publish regenerates the text, so only publish what the text would show differently
+	const PingSummary* current = m_Summary.Get();
+	if (current->target == summary.target && (current->replies == 0) == (summary.replies == 0) &&
+		current->median_ms == summary.median_ms && current->jitter_ms == summary.jitter_ms && current->lossPercent == summary.lossPercent)
+		return;
+
+	m_Summary.Publish(summary);
+}
+
+void PingProbe::Run(uint64_t now_us)
+{
+	uint64_t target = m_Target;
+	if (target == 0)
+		return;
+
+	if (target != m_WindowTarget)
+	{
+		m_Window.Clear();
+		m_WindowTarget = target;
+		m_NextPing_us = 0;
+	}
+
+	if (now_us < m_NextPing_us)
+		return;
+
+	m_NextPing_us = now_us + m_Interval_us;
+
+	uint32_t rtt_us;
+	PingResult result = MeasureConnectRtt(PingTarget{ static_cast<uint32_t>(target >> 16), static_cast<uint16_t>(target & 0xFFFF) }, m_Timeout_ms, rtt_us);
+	if (result == PING_FAILED)
+		return;
+
+	if (result == PING_REPLY)
+		m_Window.AddReply(rtt_us);
+	else
+		m_Window.AddLoss();
+
+	Publish(target);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "DoubleBuffer.hpp"
+#include "LatencyWindow.hpp"
+
+// How close a server is: a TCP handshake with it, timed from connect() until the socket turns writable. A
+// refusal also comes back after one round trip, so the port doesn't have to be open, only reachable; a
+// handshake that doesn't finish within the timeout counts as a lost probe.
+
+// host order, like ServerTable's addresses
+struct PingTarget
+{
+	uint32_t address;
+	uint16_t port;
+};
+
+struct PingSummary
+{
+	uint64_t target;           // packed PingTarget the samples were taken against
+	uint32_t replies;          // 0 means every probe in the window was lost
+	uint32_t median_ms;
+	uint32_t jitter_ms;
+	uint32_t lossPercent;
+};
+
+enum PingResult { PING_REPLY, PING_LOST, PING_FAILED };
+
+// PING_FAILED is a local error (no socket), which says nothing about the path to the server
+PingResult MeasureConnectRtt(const PingTarget& target, int32_t timeout_ms, uint32_t& rtt_us);
+
+// One handshake per interval against the target set last, summarised over the last WindowSize probes.
+// One socket at a time: Run() belongs to the probe thread, SetTarget() and the summaries to the watcher,
+// which only reads what Run() published.
+class PingProbe
+{
+public:
+	static constexpr size_t WindowSize = 16;
+
+	PingProbe(uint64_t interval_us, int32_t timeout_ms) : m_Interval_us(interval_us), m_Timeout_ms(timeout_ms) {}
+
+	static uint64_t Pack(const PingTarget& target)
+	{
+		return target.address ? (static_cast<uint64_t>(target.address) << 16) | target.port : 0;
+	}
+
+	// a zero address stops probing
+	void SetTarget(const PingTarget& target) { m_Target = Pack(target); }
+
+	// rate limited to one handshake per interval, a new target starts over with an empty window
+	void Run(uint64_t now_us);
+
+	// nullptr until there's a summary for this very target
+	const PingSummary* GetSummary(const PingTarget& target) const
+	{
+		const PingSummary* summary = m_Summary.Get();
+		return target.address && summary->target == Pack(target) ? summary : nullptr;
+	}
+
+	// whatever was published last; a new pointer means a new summary
+	const PingSummary* GetLatest() const { return m_Summary.Get(); }
+
+private:
+	void Publish(uint64_t target);
+
+private:
+	uint64_t m_Interval_us;
+	int32_t m_Timeout_ms;
+
+	volatile uint64_t m_Target = 0; // packed so the probe thread never sees half of a new target
+	DoubleBuffer<PingSummary> m_Summary;
+	LatencyWindow<WindowSize> m_Window;
+	uint64_t m_WindowTarget = 0;
+	uint64_t m_NextPing_us = 0;
+};
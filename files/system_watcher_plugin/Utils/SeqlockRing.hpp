@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ppu_intrinsics.h>
+
+// Fixed-size history written by one thread and read by any number of others without locks. Every slot
+// carries its own sequence counter, odd while the producer is writing it, so a reader copies the entry
+// and checks the counter didn't move underneath it. Readers never block the producer; the producer simply
+// overwrites the oldest entry, and a reader that lost that race, or caught the slot mid-write, gets false
+// rather than a torn value. Reading never waits on the producer, which may be descheduled mid-write.
+// T has to be trivially copyable.
+template<typename T, size_t Size>
+class SeqlockRing
+{
+public:
+	static_assert(Size > 0 && (Size & (Size - 1)) == 0, "the ring size should be a power of two");
+
+	// producer only
+	void Push(const T& value)
+	{
+		uint32_t position = m_Written;
+		Slot& slot = m_Slots[position & (Size - 1)];
+
+		slot.sequence = slot.sequence + 1;
+		__lwsync();
+		slot.position = position;
+		slot.value = value;
+		__lwsync();
+		slot.sequence = slot.sequence + 1;
+
+		__lwsync();
+		m_Written = position + 1;
+	}
+
+	// entries pushed so far, the ring holds the last min(written, Size) of them
+	uint32_t GetWritten() const { return m_Written; }
+	size_t GetCount() const { return m_Written < Size ? m_Written : Size; }
+
+	// `age` 0 is the newest entry. False when there's no such entry, or the producer is rewriting its slot.
+	bool Read(uint32_t age, T& value) const
+	{
+		uint32_t written = m_Written;
+		__lwsync();
+		if (age >= written || age >= Size)
+			return false;
+
+		uint32_t position = written - 1 - age;
+		const Slot& slot = m_Slots[position & (Size - 1)];
+		uint32_t before = slot.sequence;
+		if (before & 1)
+			return false;
+
+		__lwsync();
+		uint32_t copied = slot.position;
+		value = slot.value;
+		__lwsync();
+
+		// a slot only moves on when the producer wraps around to it, so there's nothing to retry for
+		return slot.sequence == before && copied == position;
+	}
+
+private:
+	struct Slot
+	{
+		volatile uint32_t sequence;
+		uint32_t position;
+		T value;
+	};
+
+	Slot m_Slots[Size]{};
+	volatile uint32_t m_Written = 0;
+};
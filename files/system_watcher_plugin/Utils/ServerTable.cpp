@@ -0,0 +1,209 @@
+#include "ServerTable.hpp"
+#include "Utf8.hpp"
+#include <algorithm>
+#include <cstring>
+
+bool ServerTable::ParseIpv4(const char* text, size_t maxLength, uint32_t& address)
+{
+	uint32_t value = 0, part = 0;
+	int parts = 0, digits = 0;
+
+	for (size_t i = 0; i <= maxLength; i++)
+	{
+		char c = i < maxLength ? text[i] : '\0';
+		if (c >= '0' && c <= '9')
+		{
+			part = part * 10 + (c - '0');
+			if (++digits > 3 || part > 255)
+				return false;
+			continue;
+		}
+
+		if (c != '.' && c != '\0' && c != ' ' && c != '\t' && c != '\r' && c != '\n')
+			return false;
+
+		if (digits == 0 || parts == 4)
+			return false;
+
+		value = (value << 8) | part;
+		parts++;
+		part = 0;
+		digits = 0;
+
+		if (c != '.')
+			break;
+	}
+
+	if (parts != 4)
+		return false;
+
+	address = value;
+	return true;
+}
+
+namespace
+{
+	uint32_t PrefixMask(uint32_t prefixLength)
+	{
+		return prefixLength ? 0xFFFFFFFFu << (32 - prefixLength) : 0;
+	}
+}
+
+bool ServerTable::ParseCidr(const char* text, size_t maxLength, uint32_t& network, uint32_t& prefixLength)
+{
+	size_t slash = 0;
+	while (slash < maxLength && text[slash] != '/' && text[slash] != '\0' && text[slash] != ' ' && text[slash] != '\t' &&
+		text[slash] != '\r' && text[slash] != '\n')
+		slash++;
+
+	uint32_t address;
+	if (!ParseIpv4(text, slash, address))
+		return false;
+
+	uint32_t length = 32;
+	if (slash < maxLength && text[slash] == '/')
+	{
+		length = 0;
+		int digits = 0;
+		for (size_t i = slash + 1; i < maxLength && text[i] >= '0' && text[i] <= '9'; i++)
+		{
+			length = length * 10 + (text[i] - '0');
+			if (++digits > 2 || length > 32)
+				return false;
+		}
+
+		size_t end = slash + 1 + digits;
+		if (digits == 0 || (end < maxLength && text[end] != '\0' && text[end] != ' ' && text[end] != '\t' && text[end] != '\r' && text[end] != '\n'))
+			return false;
+	}
+
+	network = address & PrefixMask(length);
+	prefixLength = length;
+	return true;
+}
+
+void ServerTable::Clear()
+{
+	m_Count = 0;
+	m_Dropped = 0;
+	m_PoolUsed = 0;
+	m_LineLength = 0;
+	m_LineOverflowed = false;
+}
+
+const ServerTable::Entry* ServerTable::LowerBound(uint32_t network, uint32_t prefixLength) const
+{
+	return std::lower_bound(m_Entries, m_Entries + m_Count, Entry{ network, prefixLength, nullptr }, [](const Entry& entry, const Entry& value) {
+		return entry.network != value.network ? entry.network < value.network : entry.prefixLength < value.prefixLength;
+	});
+}
+
+const ServerTable::Entry* ServerTable::Find(uint32_t network, uint32_t prefixLength) const
+{
+	const Entry* entry = LowerBound(network, prefixLength);
+	return (entry != m_Entries + m_Count && entry->network == network && entry->prefixLength == prefixLength) ? entry : nullptr;
+}
+
+bool ServerTable::AddRange(uint32_t network, uint32_t prefixLength, const wchar_t* name)
+{
+	if (prefixLength > 32)
+		return false;
+
+	network &= PrefixMask(prefixLength);
+	size_t index = LowerBound(network, prefixLength) - m_Entries;
+	if (index < m_Count && m_Entries[index].network == network && m_Entries[index].prefixLength == prefixLength)
+		return false;
+
+	if (m_Count >= m_MaxServers)
+	{
+		m_Dropped++;
+		return false;
+	}
+
+	memmove(&m_Entries[index + 1], &m_Entries[index], (m_Count - index) * sizeof(Entry));
+	m_Entries[index] = Entry{ network, prefixLength, name };
+	m_Count++;
+	return true;
+}
+
+void ServerTable::Feed(const char* data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		char c = data[i];
+		if (c == '\n')
+		{
+			ParseLine();
+			continue;
+		}
+
+		// the rest of an overlong line is skipped, ParseLine() still sees whether it held an entry
+		if (m_LineLength < MaxLineLength)
+			m_Line[m_LineLength++] = c;
+		else
+			m_LineOverflowed = true;
+	}
+}
+
+void ServerTable::Finish()
+{
+	if (m_LineLength || m_LineOverflowed)
+		ParseLine();
+}
+
+void ServerTable::ParseLine()
+{
+	const char* line = m_Line;
+	const char* end = m_Line + m_LineLength;
+	bool overflowed = m_LineOverflowed;
+	m_LineLength = 0;
+	m_LineOverflowed = false;
+
+	while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+		end--;
+
+	const char* name = line;
+	while (name < end && *name != ' ' && *name != '\t')
+		name++;
+
+	size_t addressLength = name - line;
+	while (name < end && (*name == ' ' || *name == '\t'))
+		name++;
+
+	uint32_t network, prefixLength;
+	size_t nameLength = end - name;
+	if (line == end || *line == '#' || (nameLength == 0 && !overflowed) || !ParseCidr(line, addressLength, network, prefixLength))
+		return;
+
+	if (Find(network, prefixLength))
+		return;
+
+	// names are UTF-8, which never decodes to more units than it has bytes
+	if (overflowed || m_Count >= m_MaxServers || m_PoolUsed + nameLength + 1 > m_NamePoolSize)
+	{
+		m_Dropped++;
+		return;
+	}
+
+	wchar_t* pooled = &m_NamePool[m_PoolUsed];
+	Utf8::DecodeResult decoded = Utf8::Decode(name, nameLength, pooled, m_NamePoolSize - m_PoolUsed);
+	if (AddRange(network, prefixLength, pooled))
+		m_PoolUsed += decoded.written + 1;
+}
+
+const wchar_t* ServerTable::FindByDns(uint32_t dns) const
+{
+	const Entry* entry = Find(dns, 32);
+	return entry ? entry->name : nullptr;
+}
+
+const wchar_t* ServerTable::FindByRange(uint32_t address) const
+{
+	const Entry* best = nullptr;
+	for (const Entry* entry = m_Entries; entry != m_Entries + m_Count && entry->network <= address; entry++)
+	{
+		if ((address & PrefixMask(entry->prefixLength)) == entry->network && (!best || entry->prefixLength > best->prefixLength))
+			best = entry;
+	}
+	return best ? best->name : nullptr;
+}
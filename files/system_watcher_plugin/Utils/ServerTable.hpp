@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Maps revival network DNS addresses to their names. The addresses are parsed to integers once and kept
+// sorted, so a lookup is a binary search instead of a chain of string compares.
+// A table is loaded from "<dns address> <server name>" lines, '#' starts a comment line. The address may
+// also be a CIDR range, "<network>/<prefix length> <server name>", for the hosts a network answers DNS
+// queries with; a plain address is a range of one. The text is fed in chunks of any size like
+// XmlValueExtractor, so a file of any length costs one small read buffer; the names are decoded from UTF-8
+// into a fixed pool. Entries that don't fit, in the table, the pool or the line buffer, are counted rather
+// than silently lost. The first entry for an address or range wins.
+// Storage is fixed and nothing allocates: FixedServerTable below provides it, sized by whoever declares one.
+// Loading is single-threaded; once it's done any thread can look up, and the returned names stay valid until
+// the next Clear().
+class ServerTable
+{
+public:
+	static constexpr size_t MaxLineLength = 255;
+
+	// dotted quad to a host order integer, false on anything that isn't exactly four 0-255 parts.
+	// Parsing stops at the first NUL or whitespace within `maxLength`
+	static bool ParseIpv4(const char* text, size_t maxLength, uint32_t& address);
+
+	// an address with an optional "/0".."/32" suffix, a plain address being a /32. Host bits are cleared
+	static bool ParseCidr(const char* text, size_t maxLength, uint32_t& network, uint32_t& prefixLength);
+
+	void Clear();
+
+	// `name` isn't copied, it has to outlive the table. False when the address or range is already known or
+	// the table is full, only the latter counts as dropped
+	bool Add(uint32_t dns, const wchar_t* name) { return AddRange(dns, 32, name); }
+	bool AddRange(uint32_t network, uint32_t prefixLength, const wchar_t* name);
+
+	void Feed(const char* data, size_t length);
+
+	// to be called at the end of the input, settles a last line without a newline
+	void Finish();
+
+	// plain addresses only, a range doesn't name a DNS server
+	const wchar_t* FindByDns(uint32_t dns) const;
+
+	// the most specific entry whose range holds `address`. Revival networks answer with their own hosts,
+	// which only match the ranges listed for them. A scan, it's meant for the odd probe answer
+	const wchar_t* FindByRange(uint32_t address) const;
+
+	size_t GetCount() const { return m_Count; }
+	uint32_t GetDroppedCount() const { return m_Dropped; }
+	size_t GetMaxServers() const { return m_MaxServers; }
+	size_t GetNamePoolSize() const { return m_NamePoolSize; }
+
+protected:
+	// sorted by network, then prefix length
+	struct Entry
+	{
+		uint32_t network;
+		uint32_t prefixLength;
+		const wchar_t* name;
+	};
+
+	// `namePoolSize` in wchar_t units, terminators included
+	ServerTable(Entry* entries, size_t maxServers, wchar_t* namePool, size_t namePoolSize)
+		: m_Entries(entries), m_MaxServers(maxServers), m_NamePool(namePool), m_NamePoolSize(namePoolSize) {}
+
+	// the storage belongs to the derived table, a copy would point into someone else's
+	ServerTable(const ServerTable&) = delete;
+	ServerTable& operator=(const ServerTable&) = delete;
+
+private:
+	void ParseLine();
+	const Entry* LowerBound(uint32_t network, uint32_t prefixLength) const;
+	const Entry* Find(uint32_t network, uint32_t prefixLength) const;
+
+private:
+	Entry* m_Entries;
+	size_t m_MaxServers;
+	size_t m_Count = 0;
+	uint32_t m_Dropped = 0;
+
+	wchar_t* m_NamePool;
+	size_t m_NamePoolSize;
+	size_t m_PoolUsed = 0;
+
+	char m_Line[MaxLineLength + 1]{};
+	size_t m_LineLength = 0;
+	bool m_LineOverflowed = false;
+};
+
+template<size_t MaxServers, size_t NamePoolSize>
+class FixedServerTable : public ServerTable
+{
+public:
+	FixedServerTable() : ServerTable(m_EntryStorage, MaxServers, m_NamePoolStorage, NamePoolSize) {}
+
+private:
+	Entry m_EntryStorage[MaxServers]{};
+	wchar_t m_NamePoolStorage[NamePoolSize]{};
+};
@@ -10,7 +10,7 @@ public:
 	Thread()
 		: bJoinable(false) {}
 
-	Thread(void(*callback)(), Thread* thisObj, std::string const& name = "Thread()")
+	Thread(void(*callback)(), Thread* thisObj, std::string const& name = "Thread()", unsigned int stackSize = StackSize)
 		: bJoinable(true), fnCallback(callback), pObj(thisObj)
 	{
 		sys_ppu_thread_create(&u64Id, [](uint64_t arg) -> void
@@ -22,7 +22,7 @@ public:
 
 			sys_ppu_thread_exit(0);
 
-		}, reinterpret_cast<uint64_t>(thisObj), Priority, StackSize, SYS_PPU_THREAD_CREATE_JOINABLE, name.c_str());
+		}, reinterpret_cast<uint64_t>(thisObj), Priority, stackSize, SYS_PPU_THREAD_CREATE_JOINABLE, name.c_str());
 	}
 
 	bool IsJoinable() {
@@ -41,5 +41,5 @@ public:
 	Thread* pObj;
 
 	static constexpr int Priority = 1000; // thread priority 0=highest, 3071=lowest
-	static constexpr unsigned int StackSize = 2048; // stack size for newly created threads
+	static constexpr unsigned int StackSize = 2048; // default stack size for newly created threads
 };
\ No newline at end of file
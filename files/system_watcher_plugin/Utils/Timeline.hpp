@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Timer.hpp"
+
+struct Keyframe
+{
+	uint64_t time_us;            // offset from the start of the timeline, the first key sits at 0
+	float value;
+	float(*ease)(float);         // easing of the segment that ends on this key, nullptr holds the previous value
+};
+
+// A fixed list of keyframes evaluated as a pure function of (start, now): nothing is stored per call, so
+// every caller in the same frame sees the same value no matter which widget asks first.
+// Looping timelines wrap around their last key, which should carry the same value as the first.
+class Timeline
+{
+public:
+	static constexpr size_t Finished = ~static_cast<size_t>(0);
+
+	template<size_t N>
+	constexpr Timeline(const Keyframe(&keys)[N], bool looping)
+		: m_Keys(keys), m_Count(N), m_Duration(keys[N - 1].time_us), m_Looping(looping)
+	{
+		static_assert(N >= 2, "a timeline needs at least two keys");
+	}
+
+	uint64_t GetDuration() const { return m_Duration; }
+
+	// Index of the key the segment running at `now` ends on, Finished once a one-shot timeline is over.
+	// `cycle` receives how many times a looping timeline has wrapped.
+	size_t GetSegment(uint64_t start_us, uint64_t now_us, uint32_t* cycle = nullptr) const
+	{
+		uint64_t local_us = 0;
+		return Locate(start_us, now_us, local_us, cycle);
+	}
+
+	float Evaluate(uint64_t start_us, uint64_t now_us) const
+	{
+		uint64_t local_us = 0;
+		size_t segment = Locate(start_us, now_us, local_us, nullptr);
+		if (segment == Finished)
+			return m_Keys[m_Count - 1].value;
+
+		const Keyframe& from = m_Keys[segment - 1];
+		const Keyframe& to = m_Keys[segment];
+		if (!to.ease)
+			return from.value;
+
+		float progress = static_cast<float>(local_us - from.time_us) / static_cast<float>(to.time_us - from.time_us);
+		return from.value + (to.value - from.value) * to.ease(progress);
+	}
+
+private:
+	size_t Locate(uint64_t start_us, uint64_t now_us, uint64_t& local_us, uint32_t* cycle) const
+	{
+		local_us = now_us > start_us ? now_us - start_us : 0;
+		if (cycle)
+			*cycle = 0;
+
+		if (local_us >= m_Duration)
+		{
+			if (!m_Looping || m_Duration == 0)
+				return Finished;
+
+			if (cycle)
+				*cycle = static_cast<uint32_t>(local_us / m_Duration);
+			local_us %= m_Duration;
+		}
+
+		// the timelines here have a handful of keys, a linear scan beats anything cleverer
+		size_t segment = 1;
+		while (m_Keys[segment].time_us <= local_us)
+			segment++;
+
+		return segment;
+	}
+
+private:
+	const Keyframe* m_Keys;
+	size_t m_Count;
+	uint64_t m_Duration;
+	bool m_Looping;
+};
@@ -0,0 +1,229 @@
+#include "Utf8.hpp"
+#include <cstring>
+
+#ifdef __ALTIVEC__
+#include <altivec.h>
+#endif
+
+namespace Utf8
+{
+	namespace
+	{
+		constexpr uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+		// false when the code point doesn't fit in front of the terminator
+		bool Put(uint32_t codePoint, wchar_t* destination, size_t capacity, size_t& written)
+		{
+			if (sizeof(wchar_t) == 2 && codePoint > 0xFFFF)
+			{
+				if (written + 2 >= capacity)
+					return false;
+
+				codePoint -= 0x10000;
+				destination[written++] = static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+				destination[written++] = static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+				return true;
+			}
+
+			if (written + 1 >= capacity)
+				return false;
+
+			destination[written++] = static_cast<wchar_t>(codePoint);
+			return true;
+		}
+
+		// Both ASCII paths widen the run of ASCII bytes at the start of `source` and return its length.
+		size_t WidenAsciiScalar(const uint8_t* source, size_t length, wchar_t* destination)
+		{
+			size_t i = 0;
+
+			// eight bytes at a time for as long as none of them has the top bit set
+			for (; i + 8 <= length; i += 8)
+			{
+				uint64_t word;
+				memcpy(&word, source + i, sizeof(word));
+				if (word & 0x8080808080808080ull)
+					break;
+
+				for (size_t j = 0; j < 8; j++)
+					destination[i + j] = static_cast<wchar_t>(source[i + j]);
+			}
+
+			while (i < length && source[i] < 0x80)
+			{
+				destination[i] = static_cast<wchar_t>(source[i]);
+				i++;
+			}
+
+			return i;
+		}
+
+#ifdef __ALTIVEC__
+		// vec_perm() picks from (zero, bytes), so indices 16 and up are source bytes: each row zero-extends
+		// the next slice of the 16 loaded bytes into big-endian wchar_t lanes
+		__attribute__((aligned(16))) const uint8_t WIDEN_32[4][16] =
+		{
+			{ 0, 0, 0, 16, 0, 0, 0, 17, 0, 0, 0, 18, 0, 0, 0, 19 },
+			{ 0, 0, 0, 20, 0, 0, 0, 21, 0, 0, 0, 22, 0, 0, 0, 23 },
+			{ 0, 0, 0, 24, 0, 0, 0, 25, 0, 0, 0, 26, 0, 0, 0, 27 },
+			{ 0, 0, 0, 28, 0, 0, 0, 29, 0, 0, 0, 30, 0, 0, 0, 31 },
+		};
+
+		__attribute__((aligned(16))) const uint8_t WIDEN_16[2][16] =
+		{
+			{ 0, 16, 0, 17, 0, 18, 0, 19, 0, 20, 0, 21, 0, 22, 0, 23 },
+			{ 0, 24, 0, 25, 0, 26, 0, 27, 0, 28, 0, 29, 0, 30, 0, 31 },
+		};
+
+		size_t WidenAsciiVector(const uint8_t* source, size_t length, wchar_t* destination)
+		{
+			size_t i = 0;
+
+			// scalar until the stores are aligned, the loads can stay unaligned
+			while (i < length && (reinterpret_cast<uintptr_t>(destination + i) & 15) != 0)
+			{
+				if (source[i] >= 0x80)
+					return i;
+
+				destination[i] = static_cast<wchar_t>(source[i]);
+				i++;
+			}
+
+			const vector unsigned char zero = vec_splat_u8(0);
+			const vector unsigned char topBit = vec_sl(vec_splat_u8(1), vec_splat_u8(7));
+
+			for (; i + 16 <= length; i += 16)
+			{
+				// vec_ld(15, p) reads the aligned block holding the last wanted byte, never past the input
+				const uint8_t* p = source + i;
+				vector unsigned char bytes = vec_perm(vec_ld(0, p), vec_ld(15, p), vec_lvsl(0, p));
+				if (vec_any_ge(bytes, topBit))
+					break;
+
+				unsigned char* out = reinterpret_cast<unsigned char*>(destination + i);
+				if (sizeof(wchar_t) == 4)
+				{
+					for (int k = 0; k < 4; k++)
+						vec_st(vec_perm(zero, bytes, vec_ld(0, WIDEN_32[k])), k * 16, out);
+				}
+				else
+				{
+					for (int k = 0; k < 2; k++)
+						vec_st(vec_perm(zero, bytes, vec_ld(0, WIDEN_16[k])), k * 16, out);
+				}
+			}
+
+			return i + WidenAsciiScalar(source + i, length - i, destination + i);
+		}
+#endif
+
+		size_t WidenAscii(const uint8_t* source, size_t length, wchar_t* destination)
+		{
+#ifdef __ALTIVEC__
+			return WidenAsciiVector(source, length, destination);
+#else
+			return WidenAsciiScalar(source, length, destination);
+#endif
+		}
+	}
+
+	DecodeResult Decode(const char* source, size_t length, wchar_t* destination, size_t capacity)
+	{
+		DecodeResult result{};
+		if (capacity == 0)
+		{
+			result.truncated = length > 0;
+			return result;
+		}
+
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(source);
+		size_t i = 0, written = 0;
+
+		while (i < length)
+		{
+			if (bytes[i] < 0x80)
+			{
+				size_t room = capacity - 1 - written;
+				if (room == 0)
+				{
+					result.truncated = true;
+					break;
+				}
+
+				size_t run = WidenAscii(bytes + i, length - i < room ? length - i : room, destination + written);
+				i += run;
+				written += run;
+				continue;
+			}
+
+			uint32_t lead = bytes[i];
+			uint32_t codePoint = 0, minimum = 0;
+			size_t continuations = 0;
+			if (lead >= 0xC2 && lead <= 0xDF)
+			{
+				continuations = 1;
+				codePoint = lead & 0x1F;
+				minimum = 0x80;
+			}
+			else if ((lead & 0xF0) == 0xE0)
+			{
+				continuations = 2;
+				codePoint = lead & 0x0F;
+				minimum = 0x800;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4)
+			{
+				continuations = 3;
+				codePoint = lead & 0x07;
+				minimum = 0x10000;
+			}
+
+			// a bad sequence swallows the lead and the continuations that did fit, not the byte that broke it
+			bool valid = continuations != 0;
+			size_t consumed = 1;
+			for (size_t k = 1; valid && k <= continuations; k++)
+			{
+				if (i + k >= length)
+				{
+					result.truncated = true;
+					break;
+				}
+
+				uint8_t next = bytes[i + k];
+				if ((next & 0xC0) != 0x80)
+				{
+					valid = false;
+					break;
+				}
+
+				codePoint = (codePoint << 6) | (next & 0x3F);
+				consumed++;
+			}
+
+			if (result.truncated)
+				break;
+
+			if (valid && (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)))
+				valid = false;
+
+			if (!valid)
+			{
+				codePoint = REPLACEMENT_CHARACTER;
+				result.invalid = true;
+			}
+
+			if (!Put(codePoint, destination, capacity, written))
+			{
+				result.truncated = true;
+				break;
+			}
+
+			i += consumed;
+		}
+
+		destination[written] = L'\0';
+		result.read = i;
+		result.written = written;
+		return result;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Utf8
+{
+	struct DecodeResult
+	{
+		size_t read;       // bytes consumed from the source
+		size_t written;    // wchar_t units written, not counting the terminator
+		bool truncated;    // the destination filled up, or the source ended inside a sequence
+		bool invalid;      // at least one malformed sequence was replaced with U+FFFD
+	};
+
+	// Decodes `length` bytes of UTF-8 into a terminated wide string of at most `capacity` units, terminator
+	// included. Overlong forms, surrogates and anything past U+10FFFF count as malformed. Where wchar_t is
+	// 16 bits wide, code points outside the BMP become surrogate pairs.
+	// Decoding stops at a code point boundary when the destination is full, it never cuts a pair in half.
+	DecodeResult Decode(const char* source, size_t length, wchar_t* destination, size_t capacity);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Fixed-capacity wide string meant to live in static storage, so building text never touches the heap.
+// Anything past the capacity is dropped and flagged instead of reallocating.
+template<size_t Capacity>
+class WStringBuilder
+{
+public:
+	WStringBuilder() = default;
+
+	void Clear()
+	{
+		m_Length = 0;
+		m_Truncated = false;
+		m_Buffer[0] = L'\0';
+	}
+
+	WStringBuilder& Append(wchar_t c)
+	{
+		if (m_Length + 1 >= Capacity)
+		{
+			m_Truncated = true;
+			return *this;
+		}
+
+		m_Buffer[m_Length++] = c;
+		m_Buffer[m_Length] = L'\0';
+		return *this;
+	}
+
+	WStringBuilder& Append(wchar_t c, size_t count)
+	{
+		while (count--)
+			Append(c);
+		return *this;
+	}
+
+	WStringBuilder& Append(const wchar_t* text)
+	{
+		while (*text)
+			Append(*text++);
+		return *this;
+	}
+
+	// widens byte by byte, meant for the ASCII strings netctl and xsetting hand out
+	WStringBuilder& AppendAscii(const char* text)
+	{
+		while (*text)
+			Append(static_cast<wchar_t>(static_cast<uint8_t>(*text++)));
+		return *this;
+	}
+
+	WStringBuilder& AppendUInt(uint32_t value)
+	{
+		wchar_t digits[10];
+		size_t count = 0;
+		do
+		{
+			digits[count++] = static_cast<wchar_t>(L'0' + value % 10);
+			value /= 10;
+		} while (value);
+
+		while (count)
+			Append(digits[--count]);
+		return *this;
+	}
+
+	// address in network order, as in_addr.s_addr holds it on the PPU
+	WStringBuilder& AppendIpv4(uint32_t address)
+	{
+		return AppendUInt(address >> 24).Append(L'.').AppendUInt((address >> 16) & 0xFF).Append(L'.')
+			.AppendUInt((address >> 8) & 0xFF).Append(L'.').AppendUInt(address & 0xFF);
+	}
+
+	size_t Count(wchar_t c) const
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < m_Length; i++)
+			count += m_Buffer[i] == c;
+		return count;
+	}
+
+	bool Equals(const std::wstring& other) const
+	{
+		return other.size() == m_Length && other.compare(0, m_Length, m_Buffer, m_Length) == 0;
+	}
+
+	// a destination with enough reserved capacity takes the copy without allocating
+	void CopyTo(std::wstring& destination) const
+	{
+		destination.assign(m_Buffer, m_Length);
+	}
+
+	const wchar_t* GetBuffer() const { return m_Buffer; }
+	size_t GetLength() const { return m_Length; }
+	bool IsTruncated() const { return m_Truncated; }
+
+private:
+	wchar_t m_Buffer[Capacity]{};
+	size_t m_Length = 0;
+	bool m_Truncated = false;
+};
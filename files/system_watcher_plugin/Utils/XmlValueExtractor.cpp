@@ -0,0 +1,426 @@
+#include "XmlValueExtractor.hpp"
+#include <cstring>
+
+XmlValueExtractor::XmlValueExtractor(const char* element, const char* attribute, char* output, size_t capacity)
+	: m_Element(element), m_Attribute(attribute), m_Output(output), m_Capacity(capacity)
+{
+	if (m_Capacity)
+		m_Output[0] = '\0';
+}
+
+bool XmlValueExtractor::Feed(const char* data, size_t length)
+{
+	static const char BOM[] = "\xEF\xBB\xBF";
+
+	for (size_t i = 0; i < length && !m_Found; i++)
+	{
+		char c = data[i];
+		switch (m_Mode)
+		{
+		case MODE_UNDECIDED:
+			// a byte order mark and leading blanks don't tell plain text from markup yet
+			if (m_Match < 3 && c == BOM[m_Match])
+			{
+				m_Match++;
+				break;
+			}
+
+			if (IsSpace(c))
+				break;
+
+			m_Match = 0;
+			if (c == '<')
+			{
+				m_Mode = MODE_MARKUP;
+				m_State = STATE_TAG_OPEN;
+			}
+			else
+			{
+				m_Mode = MODE_PLAIN;
+				m_Collecting = true;
+				Emit(c);
+			}
+			break;
+
+		case MODE_PLAIN:
+			Emit(c);
+			break;
+
+		case MODE_MARKUP:
+			Step(c);
+			break;
+		}
+	}
+
+	return !m_Found;
+}
+
+void XmlValueExtractor::Finish()
+{
+	// plain text ends with the input, and an element left open keeps what it had
+	if (!m_Found && m_Collecting)
+		Complete();
+}
+
+bool XmlValueExtractor::NameEquals(const char* name, size_t length, bool overflowed, const char* expected)
+{
+	return expected && !overflowed && strlen(expected) == length && memcmp(name, expected, length) == 0;
+}
+
+void XmlValueExtractor::Step(char c)
+{
+	switch (m_State)
+	{
+	case STATE_TEXT:
+		if (c == '<')
+			m_State = STATE_TAG_OPEN;
+		else if (c == '&' && m_Collecting)
+		{
+			m_EntityReturn = STATE_TEXT;
+			m_EntityLength = 0;
+			m_State = STATE_ENTITY;
+		}
+		else if (m_Collecting)
+			Emit(c);
+		break;
+
+	case STATE_TAG_OPEN:
+		m_NameLength = 0;
+		m_NameOverflowed = false;
+		m_Match = 0;
+		if (c == '/')
+			m_State = STATE_END_TAG;
+		else if (c == '!')
+			m_State = STATE_BANG;
+		else if (c == '?')
+			m_State = STATE_PROCESSING_INSTRUCTION;
+		else
+		{
+			m_Name[m_NameLength++] = c;
+			m_State = STATE_START_TAG_NAME;
+		}
+		break;
+
+	case STATE_START_TAG_NAME:
+	case STATE_ATTRIBUTE_NAME:
+		if (IsSpace(c) || c == '/' || c == '>' || (m_State == STATE_ATTRIBUTE_NAME && c == '='))
+		{
+			if (m_State == STATE_START_TAG_NAME)
+			{
+				m_InTargetTag = !m_Collecting && NameEquals(m_Name, m_NameLength, m_NameOverflowed, m_Element);
+				m_State = STATE_ATTRIBUTES;
+			}
+			else
+			{
+				m_State = STATE_ATTRIBUTE_EQUALS;
+			}
+
+			if (c == '>')
+				StartElement(false);
+			else if (c == '/')
+				m_State = STATE_SELF_CLOSE;
+		}
+		else if (m_NameLength < MaxNameLength)
+			m_Name[m_NameLength++] = c;
+		else
+			m_NameOverflowed = true;
+		break;
+
+	case STATE_ATTRIBUTES:
+	case STATE_ATTRIBUTE_EQUALS:
+		if (c == '>')
+			StartElement(false);
+		else if (c == '/')
+			m_State = STATE_SELF_CLOSE;
+		else if (m_State == STATE_ATTRIBUTE_EQUALS && (c == '"' || c == '\''))
+		{
+			m_Quote = c;
+			m_Collecting = m_InTargetTag && NameEquals(m_Name, m_NameLength, m_NameOverflowed, m_Attribute);
+			m_State = STATE_ATTRIBUTE_VALUE;
+		}
+		else if (!IsSpace(c) && c != '=')
+		{
+			// the next attribute's name, or one that came without a value
+			m_NameLength = 0;
+			m_NameOverflowed = false;
+			m_Name[m_NameLength++] = c;
+			m_State = STATE_ATTRIBUTE_NAME;
+		}
+		break;
+
+	case STATE_ATTRIBUTE_VALUE:
+		if (c == m_Quote)
+		{
+			if (m_Collecting)
+				Complete();
+			else
+				m_State = STATE_ATTRIBUTES;
+		}
+		else if (c == '&' && m_Collecting)
+		{
+			m_EntityReturn = STATE_ATTRIBUTE_VALUE;
+			m_EntityLength = 0;
+			m_State = STATE_ENTITY;
+		}
+		else if (m_Collecting)
+			Emit(c);
+		break;
+
+	case STATE_SELF_CLOSE:
+		if (c == '>')
+			StartElement(true);
+		break;
+
+	case STATE_END_TAG:
+		// the name isn't checked, nesting depth is all that's needed to find the end of the target
+		if (c == '>')
+			EndElement();
+		break;
+
+	case STATE_BANG:
+		// "<!--" or "<![CDATA[", anything else is a declaration such as <!DOCTYPE>; m_Quote remembers which
+		// opener is being matched
+		{
+			static const char COMMENT_OPEN[] = "--";
+			static const char CDATA_OPEN[] = "[CDATA[";
+
+			if (m_Match == 0)
+				m_Quote = c;
+
+			const char* opener = m_Quote == '-' ? COMMENT_OPEN : CDATA_OPEN;
+			if (c != opener[m_Match])
+			{
+				m_Match = 0;
+				m_State = c == '>' ? STATE_TEXT : STATE_DECLARATION;
+				break;
+			}
+
+			if (opener[++m_Match] == '\0')
+			{
+				m_Match = 0;
+				m_State = m_Quote == '-' ? STATE_COMMENT : STATE_CDATA;
+			}
+		}
+		break;
+
+	case STATE_COMMENT:
+		if (c == '>' && m_Match >= 2)
+			m_State = STATE_TEXT;
+		else
+			m_Match = c == '-' ? m_Match + 1 : 0;
+		break;
+
+	case STATE_CDATA:
+		if (c == ']')
+		{
+			// only the last two brackets can belong to "]]>"
+			if (m_Match == 2 && m_Collecting)
+				Emit(']');
+			else if (m_Match < 2)
+				m_Match++;
+		}
+		else if (c == '>' && m_Match == 2)
+		{
+			m_Match = 0;
+			m_State = STATE_TEXT;
+		}
+		else
+		{
+			for (; m_Match > 0; m_Match--)
+			{
+				if (m_Collecting)
+					Emit(']');
+			}
+
+			if (m_Collecting)
+				Emit(c);
+		}
+		break;
+
+	case STATE_DECLARATION:
+		// a DOCTYPE's internal subset can hold '>' between its brackets
+		if (c == '[')
+			m_Match++;
+		else if (c == ']' && m_Match > 0)
+			m_Match--;
+		else if (c == '>' && m_Match == 0)
+			m_State = STATE_TEXT;
+		break;
+
+	case STATE_PROCESSING_INSTRUCTION:
+		if (c == '>' && m_Match)
+			m_State = STATE_TEXT;
+		else
+			m_Match = c == '?';
+		break;
+
+	case STATE_ENTITY:
+		if (c == ';')
+		{
+			m_State = m_EntityReturn;
+			ResolveEntity();
+		}
+		else if (m_EntityLength < sizeof(m_Entity) - 1 && c != '&' && c != '<' && !IsSpace(c) && !(m_EntityReturn == STATE_ATTRIBUTE_VALUE && c == m_Quote))
+		{
+			m_Entity[m_EntityLength++] = c;
+		}
+		else
+		{
+			// not an entity after all, keep it as written and handle `c` where it came from
+			m_State = m_EntityReturn;
+			Emit('&');
+			for (size_t i = 0; i < m_EntityLength; i++)
+				Emit(m_Entity[i]);
+			if (!m_Found)
+				Step(c);
+		}
+		break;
+	}
+}
+
+void XmlValueExtractor::StartElement(bool selfClosing)
+{
+	bool isTarget = m_InTargetTag && !m_Attribute;
+	m_InTargetTag = false;
+	m_State = STATE_TEXT;
+
+	if (selfClosing)
+	{
+		if (isTarget)
+			Complete();
+		return;
+	}
+
+	m_Depth++;
+	if (isTarget)
+	{
+		m_Collecting = true;
+		m_TargetDepth = m_Depth;
+	}
+}
+
+void XmlValueExtractor::EndElement()
+{
+	m_State = STATE_TEXT;
+	if (m_Collecting && m_Depth == m_TargetDepth)
+	{
+		Complete();
+		return;
+	}
+
+	if (m_Depth)
+		m_Depth--;
+}
+
+void XmlValueExtractor::Emit(char c)
+{
+	if (m_Found)
+		return;
+
+	// surrounding whitespace is trimmed, the leading part right here and the trailing part in Complete()
+	if (m_Length == 0 && IsSpace(c))
+		return;
+
+	if (m_Length + 1 >= m_Capacity)
+	{
+		m_Truncated = true;
+		Complete();
+		return;
+	}
+
+	m_Output[m_Length++] = c;
+}
+
+void XmlValueExtractor::EmitCodePoint(uint32_t codePoint)
+{
+	if (codePoint == 0 || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+		codePoint = 0xFFFD;
+
+	if (codePoint < 0x80)
+		Emit(static_cast<char>(codePoint));
+	else if (codePoint < 0x800)
+	{
+		Emit(static_cast<char>(0xC0 | (codePoint >> 6)));
+		Emit(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+	else if (codePoint < 0x10000)
+	{
+		Emit(static_cast<char>(0xE0 | (codePoint >> 12)));
+		Emit(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		Emit(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+	else
+	{
+		Emit(static_cast<char>(0xF0 | (codePoint >> 18)));
+		Emit(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+		Emit(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		Emit(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+}
+
+void XmlValueExtractor::ResolveEntity()
+{
+	static const struct { const char* name; char value; } NAMED[] =
+	{
+		{ "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' }, { "apos", '\'' },
+	};
+
+	m_Entity[m_EntityLength] = '\0';
+	for (const auto& named : NAMED)
+	{
+		if (strcmp(m_Entity, named.name) == 0)
+		{
+			Emit(named.value);
+			return;
+		}
+	}
+
+	if (m_Entity[0] == '#' && m_EntityLength > 1)
+	{
+		bool hex = m_Entity[1] == 'x' || m_Entity[1] == 'X';
+		uint32_t codePoint = 0;
+		bool valid = m_EntityLength > (hex ? 2u : 1u);
+		for (size_t i = hex ? 2 : 1; valid && i < m_EntityLength; i++)
+		{
+			char c = m_Entity[i];
+			uint32_t digit;
+			if (c >= '0' && c <= '9')
+				digit = c - '0';
+			else if (hex && c >= 'a' && c <= 'f')
+				digit = c - 'a' + 10;
+			else if (hex && c >= 'A' && c <= 'F')
+				digit = c - 'A' + 10;
+			else
+				valid = false;
+
+			if (valid)
+				codePoint = codePoint * (hex ? 16 : 10) + digit;
+			if (codePoint > 0x10FFFF)
+				valid = false;
+		}
+
+		if (valid)
+		{
+			EmitCodePoint(codePoint);
+			return;
+		}
+	}
+
+	// unknown, keep it as written
+	Emit('&');
+	for (size_t i = 0; i < m_EntityLength; i++)
+		Emit(m_Entity[i]);
+	Emit(';');
+}
+
+void XmlValueExtractor::Complete()
+{
+	while (m_Length > 0 && IsSpace(m_Output[m_Length - 1]))
+		m_Length--;
+
+	if (m_Capacity)
+		m_Output[m_Length] = '\0';
+
+	m_Collecting = false;
+	m_Found = true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Single-pass, SAX-style scan for one value in an XML stream: the character data of the first `element`,
+// or its `attribute` when one is given. Input is fed in chunks of any size and memory use is fixed, so a
+// file of any length costs one small read buffer. Comments, processing instructions, declarations and
+// CDATA sections are understood, entities are decoded.
+// Input without any markup is taken as the value itself, which keeps plain text files working.
+class XmlValueExtractor
+{
+public:
+	static constexpr size_t MaxNameLength = 63;
+
+	// the value is written to `output` as UTF-8, terminated, `capacity` includes the terminator
+	XmlValueExtractor(const char* element, const char* attribute, char* output, size_t capacity);
+
+	// false once the value is complete or the output is full, there's no point feeding more after that
+	bool Feed(const char* data, size_t length);
+
+	// to be called at the end of the input, settles a plain text value
+	void Finish();
+
+	bool IsFound() const { return m_Found; }
+	bool IsTruncated() const { return m_Truncated; }
+	bool HasMarkup() const { return m_Mode == MODE_MARKUP; }
+	size_t GetLength() const { return m_Length; }
+
+private:
+	enum Mode { MODE_UNDECIDED, MODE_MARKUP, MODE_PLAIN };
+
+	enum State
+	{
+		STATE_TEXT,
+		STATE_TAG_OPEN,
+		STATE_START_TAG_NAME,
+		STATE_END_TAG,
+		STATE_ATTRIBUTES,
+		STATE_ATTRIBUTE_NAME,
+		STATE_ATTRIBUTE_EQUALS,
+		STATE_ATTRIBUTE_VALUE,
+		STATE_SELF_CLOSE,
+		STATE_BANG,
+		STATE_COMMENT,
+		STATE_CDATA,
+		STATE_DECLARATION,
+		STATE_PROCESSING_INSTRUCTION,
+		STATE_ENTITY
+	};
+
+	void Step(char c);
+	void StartElement(bool selfClosing);
+	void EndElement();
+	void Emit(char c);
+	void EmitCodePoint(uint32_t codePoint);
+	void ResolveEntity();
+	void Complete();
+
+	static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+	static bool NameEquals(const char* name, size_t length, bool overflowed, const char* expected);
+
+private:
+	const char* m_Element;
+	const char* m_Attribute;
+	char* m_Output;
+	size_t m_Capacity;
+	size_t m_Length = 0;
+
+	Mode m_Mode = MODE_UNDECIDED;
+	State m_State = STATE_TEXT;
+	State m_EntityReturn = STATE_TEXT;
+	uint32_t m_Depth = 0;
+	uint32_t m_TargetDepth = 0;
+	bool m_Collecting = false;     // inside the target element, or its target attribute's value
+	bool m_InTargetTag = false;    // the start tag being parsed is the target element's
+	bool m_Found = false;
+	bool m_Truncated = false;
+
+	char m_Name[MaxNameLength + 1]{};
+	size_t m_NameLength = 0;
+	bool m_NameOverflowed = false;
+	char m_Quote = 0;
+	uint32_t m_Match = 0;          // progress through "--", "[CDATA[" and the markers that close them
+
+	char m_Entity[12]{};
+	size_t m_EntityLength = 0;
+};
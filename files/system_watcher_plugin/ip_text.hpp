@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "Utils/DoubleBuffer.hpp"
+#include "Utils/WStringBuilder.hpp"
+
+// A refresh runs every few seconds, so the text is built in static storage instead of a pile of temporary
+// wstrings: the only copies made are into the snapshot strings, whose capacity is reserved up front.
+constexpr size_t IP_TEXT_HEADER_CAPACITY = 512; // gIpBuffer, the pro.xml header
+constexpr size_t IP_TEXT_CAPACITY = IP_TEXT_HEADER_CAPACITY + 192; // header plus the dynamic lines
+
+typedef WStringBuilder<IP_TEXT_CAPACITY> IpTextBuilder;
+
+// ===== LINES =====
+// GenerateIpText() gathers the values from netctl, xsetting and the probes; the wording lives here.
+
+inline void AppendServerLine(IpTextBuilder& text, const wchar_t* server)
+{
+	text.Append(L"Online Server: ").Append(server).Append(L'\n');
+}
+
+// replies == 0 means every probe in the window was lost
+inline void AppendPingLine(IpTextBuilder& text, uint32_t replies, uint32_t median_ms, uint32_t jitter_ms, uint32_t lossPercent)
+{
+	text.Append(L"Ping: ");
+	if (replies == 0)
+		text.Append(L"timeout");
+	else
+	{
+		text.AppendUInt(median_ms).Append(L" ms (±").AppendUInt(jitter_ms).Append(L" ms");
+		if (lossPercent)
+			text.Append(L", ").AppendUInt(lossPercent).Append(L"% loss");
+		text.Append(L')');
+	}
+	text.Append(L'\n');
+}
+
+// the last line, no newline after it; nullptr while there's no address
+inline void AppendAddressLine(IpTextBuilder& text, const char* ip)
+{
+	text.Append(L"System IP Address: ");
+	if (ip)
+		text.AppendAscii(ip);
+	else
+		text.Append(L"0.0.0.0");
+}
+
+// ===== PUBLISHER =====
+// The watcher thread produces the text and publishes an immutable snapshot by swapping a pointer between
+// two buffers; the draw hook only ever loads that pointer.
+// A reader holds the pointer for a single SetText(), and a buffer is only rewritten two publishes later,
+// at least one watcher pass apart.
+// The pro.xml header never changes, so it lives in its own ip_text_header widget and a new IP only
+// re-lays out the short dynamic lines. Each part carries its own version, 0 until first published; the
+// header's also moves when the lines it has to sit above change.
+struct IpTextSnapshot
+{
+	std::wstring header;
+	std::wstring text;
+	uint32_t headerLift; // lines between ip_text's anchor and the header, see SetIpTextLayoutPos()
+	uint32_t headerVersion;
+	uint32_t version;
+};
+
+class IpTextPublisher
+{
+public:
+	// done once at install, so that publishing never has to grow a string
+	void Reserve()
+	{
+		for (size_t i = 0; i < 2; i++)
+		{
+			m_Snapshot.GetBuffer(i).text.reserve(IP_TEXT_CAPACITY);
+			m_Snapshot.GetBuffer(i).header.reserve(IP_TEXT_CAPACITY);
+		}
+	}
+
+	const IpTextSnapshot* Get() const { return m_Snapshot.Get(); }
+
+	// Starts a refresh, the dynamic lines go into the returned builder. An inline header goes on top of
+	// them in the same text, for the debug plugin's ip_text that has no header widget next to it.
+	IpTextBuilder& Begin(const wchar_t* header, bool headerInline)
+	{
+		m_Text.Clear();
+		m_Header.Clear();
+		m_HeaderInline = headerInline;
+		if (headerInline)
+			m_Text.Append(header).Append(L'\n');
+		else
+			m_Header.Append(header);
+		return m_Text;
+	}
+
+	// publishes what Begin() started, unless it's what the current snapshot already shows
+	bool Publish()
+	{
+		// every dynamic line ends in a newline, plus the blank line between the header and them
+		uint32_t headerLift = m_HeaderInline ? 0 : 1 + static_cast<uint32_t>(m_Text.Count(L'\n'));
+
+		const IpTextSnapshot* current = m_Snapshot.Get();
+		bool textChanged = current->version == 0 || !m_Text.Equals(current->text);
+		bool headerChanged = current->headerVersion == 0 || headerLift != current->headerLift || !m_Header.Equals(current->header);
+		if (!textChanged && !headerChanged)
+			return false;
+
+		IpTextSnapshot& next = m_Snapshot.Next();
+		m_Text.CopyTo(next.text);
+		m_Header.CopyTo(next.header);
+		next.headerLift = headerLift;
+		next.version = current->version + (textChanged ? 1 : 0);
+		next.headerVersion = current->headerVersion + (headerChanged ? 1 : 0);
+		m_Snapshot.Publish();
+		return true;
+	}
+
+private:
+	DoubleBuffer<IpTextSnapshot> m_Snapshot;
+	IpTextBuilder m_Text;
+	IpTextBuilder m_Header;
+	bool m_HeaderInline = false;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include "widget_roles.hpp"
+#include "Utils/ClockSampler.hpp"
+#include "Utils/Timeline.hpp"
+
+constexpr int LOGO_TARGET_COUNT = ROLE_POWER_SAVING_MODE_TEXT_GLOW - ROLE_PSLOGO + 1;
+
+// The only thing the logos carry from one frame to the next: the pulse starts over from dark whenever
+// a logo reappears.
+struct LogoPulse
+{
+	uint64_t start_us = 0;
+	bool wasRunning = false;
+};
+
+// Alpha of every logo widget for one frame, indexed by role - ROLE_PSLOGO. The draw hook runs this once
+// per frame epoch; each logo widget then reads its own entry.
+inline void ComputeLogoAlphas(float(&alpha)[LOGO_TARGET_COUNT], ClockState clockState, bool parentVisible, uint64_t time_us,
+	const Timeline& pulseTimeline, LogoPulse& pulse)
+{
+	float pslogoVis = 0.f, perfVis = 0.f, balVis = 0.f, powerVis = 0.f;
+
+	switch (clockState) {
+	case CLOCK_OVERCLOCK: pslogoVis = 1.f; perfVis = 1.f; break;
+	case CLOCK_BALANCED:  pslogoVis = 1.f; balVis = 1.f; break;
+	case CLOCK_UNDERCLOCK: pslogoVis = 1.f; powerVis = 1.f; break;
+	default: break;
+	}
+
+	// the pulse only runs while a logo is actually on screen, and starts over from dark whenever it reappears
+	bool pulseRunning = parentVisible && pslogoVis > 0.1f;
+	if (pulseRunning && !pulse.wasRunning)
+		pulse.start_us = time_us;
+	pulse.wasRunning = pulseRunning;
+
+	float pulseAlpha = pulseRunning ? pulseTimeline.Evaluate(pulse.start_us, time_us) : 0.f;
+
+	alpha[ROLE_PSLOGO - ROLE_PSLOGO] = pslogoVis;
+	alpha[ROLE_PSLOGO_RING - ROLE_PSLOGO] = pulseAlpha;
+	alpha[ROLE_PERFORMANCE_MODE_TEXT - ROLE_PSLOGO] = perfVis;
+	alpha[ROLE_PERFORMANCE_MODE_TEXT_GLOW - ROLE_PSLOGO] = perfVis * pulseAlpha;
+	alpha[ROLE_BALANCED_MODE_TEXT - ROLE_PSLOGO] = balVis;
+	alpha[ROLE_BALANCED_MODE_TEXT_GLOW - ROLE_PSLOGO] = balVis * pulseAlpha;
+	alpha[ROLE_POWER_SAVING_MODE_TEXT - ROLE_PSLOGO] = powerVis;
+	alpha[ROLE_POWER_SAVING_MODE_TEXT_GLOW - ROLE_PSLOGO] = powerVis * pulseAlpha;
+}
@@ -17,6 +17,7 @@ SYS_MODULE_STOP(module_stop);
 Thread gModuleStartThread;
 bool gRunning = false;
 bool gInitialized = false;
+constexpr uint64_t QUIESCENT_POLL_INTERVAL_US = 1000000;
 
 extern "C"
 {
@@ -33,12 +34,34 @@ extern "C"
 
 			while (gRunning)
 			{
-				xmb_plugin = paf::View::Find("xmb_plugin");
-				system_plugin = paf::View::Find("system_plugin");
-				page_xmb_indicator = xmb_plugin ? xmb_plugin->FindWidget("page_xmb_indicator") : nullptr;
-				page_notification = system_plugin ? system_plugin->FindWidget("page_notification") : nullptr;
+				// in game: no lookups at all, just park until the XMB comes back (or a slow poll of the mode)
+				if (gInitialized && UpdateQuiescence())
+				{
+					WaitForXmb(QUIESCENT_POLL_INTERVAL_US);
+					continue;
+				}
+
+				paf::View* xmb = paf::View::Find("xmb_plugin");
+				paf::View* system = paf::View::Find("system_plugin");
+				paf::PhWidget* indicator = xmb ? xmb->FindWidget("page_xmb_indicator") : nullptr;
+
+				paf::PhWidget* notification = system ? system->FindWidget("page_notification") : nullptr;
+
+				// a reloaded plugin or page means new widgets, possibly at addresses the draw hook already
+				// classified, and a new "indicator" parent.
+				// g_watcher is only stored to when something changed, so the line stays shared with the render thread
+				if (xmb != g_watcher.xmb_plugin || system != g_watcher.system_plugin || indicator != g_watcher.page_xmb_indicator)
+				{
+					g_watcher.xmb_plugin = xmb;
+					g_watcher.system_plugin = system;
+					g_watcher.page_xmb_indicator = indicator;
+					InvalidateWidgetCache();
+				}
+
+				if (notification != g_watcher.page_notification)
+					g_watcher.page_notification = notification;
 
-				if (!gInitialized && page_xmb_indicator)
+				if (!gInitialized && g_watcher.page_xmb_indicator)
 				{
 					if (LoadIpText())
 					{
@@ -47,9 +70,18 @@ extern "C"
 					}
 				}
 
+				if (gInitialized)
+					PublishIpText();
+
 				if (gInitialized && CanCreateIpText())
 					CreateIpText();
 
+				if (gInitialized)
+					UpdateWidgetHooks();
+
+				if (gInitialized)
+					WriteHookStats();
+
 				Timer::Sleep(500);
 			}
 
@@ -63,15 +95,18 @@ extern "C"
 	{
 		Thread moduleStopThread = Thread([]
 		{
+			// the watcher loop goes first, Remove() must not run while it can still install or bind widgets
 			gRunning = false;
+			ReleaseWaiters();
+			gModuleStartThread.Join();
+
 			if (gInitialized)
 				Remove();
 
+			// let draw calls already inside our hooks return before the module goes away
 			sys_ppu_thread_yield();
 			Timer::Sleep(1000);
 
-			gModuleStartThread.Join();
-
 		}, &moduleStopThread, "module_stop()");
 
 		moduleStopThread.Join();
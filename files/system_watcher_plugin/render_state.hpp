@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include "Utils/ClockSampler.hpp"
+#include "logo_alphas.hpp"
+
+// PPU L1/L2 line size
+#define PPU_CACHE_LINE_SIZE 128
+#define PPU_CACHE_LINE_ALIGNED __attribute__((aligned(PPU_CACHE_LINE_SIZE)))
+
+// The scalars the draw hook reads and writes per call or per frame epoch, on one line of their own. Only
+// the thread that drives the frames writes them: the render thread, or the bound controller in that mode.
+struct PPU_CACHE_LINE_ALIGNED RenderState
+{
+	// per draw call
+	uint64_t frameEpochTicks = 0;
+	uint32_t frameCalls = 0;
+	uint32_t frameTargetCalls = 0;
+	uint64_t frameTicks = 0;
+
+	// per frame epoch
+	double timebaseTicksPerUs = 0.0;
+	ClockState cachedClockState = CLOCK_STANDARD; // the sampler's, copied once per frame epoch
+	LogoPulse pulse;
+	uint32_t resumeSerial = 0;
+
+	// gameboot
+	bool gamebootAnimStarted = false;
+	uint64_t gamebootAnimStartTime_us = 0;
+	uint32_t gamebootClockSerial = 0;     // the launch the text is waiting on a prefetched clock state for
+	uint64_t gamebootClockWaitStart_us = 0;
+};
+
+static_assert(sizeof(RenderState) == PPU_CACHE_LINE_SIZE, "render thread state should fit a single cache line");
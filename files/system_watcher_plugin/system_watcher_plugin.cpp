@@ -2,63 +2,36 @@
 #include <cell/cell_fs.h>
 #include "Utils/Memory/Detours.hpp"
 #include "Utils/Syscalls.hpp"
+#include "Utils/Threads.hpp"
+#include "Utils/Timer.hpp"
+#include "Utils/Timeline.hpp"
+#include "Utils/WStringBuilder.hpp"
+#include "Utils/Utf8.hpp"
+#include "Utils/XmlValueExtractor.hpp"
+#include "Utils/ClockSampler.hpp"
+#include "Utils/DoubleBuffer.hpp"
+#include "Utils/ServerTable.hpp"
+#include "Utils/NetworkWatcher.hpp"
+#include "Utils/DnsProbe.hpp"
+#include "Utils/PingProbe.hpp"
+#include "widget_roles.hpp"
+#include "widget_cache.hpp"
+#include "widget_dispatch.hpp"
+#include "logo_alphas.hpp"
+#include "ip_text.hpp"
 #include <algorithm>
 #include <initializer_list>
 #include <string>
 #include <cstring>
 #include <sys/sys_time.h>
+#include <sys/time_util.h>
 #include <sys/prx.h>
+#include <ppu_intrinsics.h>
+#include <cell/atomic.h>
+#include <sys/synchronization.h>
 
 using address_t = char[0x10];
 
-__attribute__((noinline)) uint64_t PeekLv1(uint64_t addr)
-{
-	system_call_1(8, (uint64_t)addr);
-	return_to_user_prog(uint64_t);
-}
-
-// ===== CLOCK =====
-enum ClockState
-{
-	CLOCK_OVERCLOCK,
-	CLOCK_STANDARD,
-	CLOCK_UNDERCLOCK,
-	CLOCK_BALANCED,
-	CLOCK_ERROR
-};
-
-ClockState GetClockState()
-{
-	constexpr uint64_t GPU_CORE_CLOCK = 0x28000004028;
-	constexpr uint64_t GPU_VRAM_CLOCK = 0x28000004010;
-
-	auto readClock = [](uint64_t addr, int multiplier) -> int {
-		union {
-			struct { uint32_t junk0; uint8_t junk1, junk2, mul, junk3; };
-			uint64_t value;
-		} clock{};
-		clock.value = PeekLv1(addr);
-		return static_cast<int>(clock.mul) * multiplier;
-	};
-
-	int core_val = readClock(GPU_CORE_CLOCK, 50);
-	int rsx_val = readClock(GPU_VRAM_CLOCK, 25);
-
-	if (core_val <= 0 || rsx_val <= 0)
-		return CLOCK_ERROR;
-
-	if ((core_val > 500 && rsx_val < 650) || (core_val < 500 && rsx_val > 650))
-		return CLOCK_BALANCED;
-
-	if (core_val > 500 || rsx_val > 650)
-		return CLOCK_OVERCLOCK;
-
-	if (core_val == 500 && rsx_val == 650)
-		return CLOCK_STANDARD;
-
-	return CLOCK_UNDERCLOCK;
-}
-
 // ===== HELPERS =====
 sys_prx_id_t GetModuleHandle(const char* moduleName) { return (moduleName) ? sys_prx_get_module_id_by_name(moduleName, 0, nullptr) : sys_prx_get_my_module_id(); }
 sys_prx_module_info_t GetModuleInfo(sys_prx_id_t handle) { sys_prx_module_info_t info{}; static sys_prx_segment_info_t segments[10]{}; static char filename[SYS_PRX_MODULE_FILENAME_SIZE]{}; stdc::memset(segments, 0, sizeof(segments)); stdc::memset(filename, 0, sizeof(filename)); info.size = sizeof(info); info.segments = segments; info.segments_num = sizeof(segments) / sizeof(sys_prx_segment_info_t); info.filename = filename; info.filename_size = sizeof(filename); sys_prx_get_module_info(handle, 0, &info); return info; }
@@ -66,6 +39,9 @@ std::string GetModuleFilePath(const char* moduleName) { sys_prx_module_info_t in
 std::string RemoveBaseNameFromPath(const std::string& filePath) { size_t lastPath = filePath.find_last_of("/"); if (lastPath == std::string::npos) return filePath; return filePath.substr(0, lastPath); }
 std::string GetCurrentDir() { static std::string cachedModulePath; if (cachedModulePath.empty()) { std::string path = RemoveBaseNameFromPath(GetModuleFilePath(nullptr)); path += "/"; cachedModulePath = path; } return cachedModulePath; }
 bool FileExists(const char* filePath) { CellFsStat stat; if (cellFsStat(filePath, &stat) == CELL_FS_SUCCEEDED) return (stat.st_mode & CELL_FS_S_IFREG); return false; }
+bool FeedChunk(XmlValueExtractor& extractor, const char* data, size_t length) { return extractor.Feed(data, length); }
+bool FeedChunk(ServerTable& table, const char* data, size_t length) { table.Feed(data, length); return true; }
+template<typename Parser> bool StreamFile(const char* filePath, void* chunk, size_t size, Parser& parser) { int fd; if (cellFsOpen(filePath, CELL_FS_O_RDONLY, &fd, nullptr, 0) != CELL_FS_SUCCEEDED) return false; uint64_t read = 0; while (cellFsRead(fd, chunk, size, &read) == CELL_FS_SUCCEEDED && read > 0 && FeedChunk(parser, static_cast<const char*>(chunk), read)) {} cellFsClose(fd); parser.Finish(); return true; }
 bool ReadFile(const char* filePath, void* data, size_t size) { int fd; if (cellFsOpen(filePath, CELL_FS_O_RDONLY, &fd, nullptr, 0) == CELL_FS_SUCCEEDED) { cellFsLseek(fd, 0, CELL_FS_SEEK_SET, nullptr); cellFsRead(fd, data, size, nullptr); cellFsClose(fd); return true; } return false; }
 bool ReplaceStr(std::wstring& str, const std::wstring& from, const std::string& to) { size_t startPos = str.find(from); if (startPos == std::wstring::npos) return false; str.replace(startPos, from.length(), std::wstring(to.begin(), to.end())); return true; }
 
@@ -88,91 +64,203 @@ bool IsIpTextEnabled()
 
 // ===== GLOBALS =====
 bool gIsDebugXmbPlugin{ false };
-wchar_t gIpBuffer[512]{0};
-paf::View* xmb_plugin{};
-paf::View* system_plugin{};
-paf::PhWidget* page_xmb_indicator{};
-paf::PhWidget* page_notification{};
+wchar_t gIpBuffer[IP_TEXT_HEADER_CAPACITY]{0};
 bool g_isIpTextDisabled = false;
-ClockState g_cachedClockState = CLOCK_STANDARD;
-uint64_t g_lastClockCheckTime = 0;
-constexpr uint64_t CLOCK_CHECK_INTERVAL_US = 5000000;
-std::wstring g_cachedIpText;
-uint64_t g_lastIpTextCheckTime = 0;
-constexpr uint64_t IP_TEXT_CHECK_INTERVAL_US = 3000000;
-enum AnimationState { FADING_OUT, INVISIBLE, FADING_IN, VISIBLE };
-AnimationState g_animationState = FADING_IN;
-uint64_t g_animationStateChangeTime_us = 0;
+constexpr const char* PRO_XML_PATH = "/dev_flash/vsh/resource/explore/xmb/pro.xml";
+constexpr const char* PRO_XML_HEADER_ELEMENT = "ip_text_header";
+constexpr const char* PRO_XML_HEADER_ATTRIBUTE = nullptr; // nullptr takes the element's text
 constexpr uint64_t FADE_DURATION_US = 800000;
 constexpr uint64_t VISIBLE_DURATION_US = 25000;
 constexpr uint64_t INVISIBLE_DURATION_US = 600000;
-float g_currentPulseAlpha = 0.0f;
 bool g_is_hen = false;
+ClockSampler g_clockSampler;
+
+#ifdef SYSTEM_WATCHER_HOOK_STATS
+constexpr bool HOOK_STATS_ENABLED = true;
+#else
+constexpr bool HOOK_STATS_ENABLED = false;
+#endif
+
+// ===== HOT STATE =====
+// The draw hook runs for every widget the VSH draws. Its per-call and per-epoch scalars are the RenderState
+// line, away from the cold config above and the 2 KB gIpBuffer; watcher-written fields live in g_watcher, on
+// a line of their own. Not everything it touches is in that line: the published snapshots (g_frameState,
+// g_ipTextPublisher, g_cooperationMode) are double buffers shared between threads, and the 8 KB
+// g_widgetRoleCache, g_parentCache, g_appliedIpText and the debug-only g_hookStats sit next to their code.
+WatcherState g_watcher{};
+RenderState g_render{};
+
+// the frame clock, which is what the sampler is fed on the render thread
+uint64_t GetFrameClock_us()
+{
+	uint64_t timebase;
+	SYS_TIMEBASE_GET(timebase);
+	return static_cast<uint64_t>(timebase / g_render.timebaseTicksPerUs);
+}
 
 // ===== GAMEBOOT GLOBALS  =====
-bool g_gamebootAnimStarted = false;
-uint64_t g_gamebootAnimStartTime_us = 0;
-bool g_gamebootWidgetSeenThisFrame = false;
 constexpr uint64_t GB_HOLD_DURATION_US = 3600000;
 constexpr uint64_t GB_FADE_OUT_DURATION_US = 2000000;
 constexpr uint64_t GB_FADE_OUT_START_TIME_US = GB_HOLD_DURATION_US;
 constexpr uint64_t GB_ANIMATION_TOTAL_DURATION_US = GB_FADE_OUT_START_TIME_US + GB_FADE_OUT_DURATION_US;
+constexpr uint64_t GB_CLOCK_WAIT_US = 100000; // a prefetch that hasn't landed by then won't, the published state is used
+
+// ===== TIMELINES =====
+// fade in, short hold, fade out, long gap, then around again
+constexpr Keyframe PULSE_KEYFRAMES[] =
+{
+	{ 0, 0.f, nullptr },
+	{ FADE_DURATION_US, 1.f, Ease::Linear },
+	{ FADE_DURATION_US + VISIBLE_DURATION_US, 1.f, nullptr },
+	{ 2 * FADE_DURATION_US + VISIBLE_DURATION_US, 0.f, Ease::Linear },
+	{ 2 * FADE_DURATION_US + VISIBLE_DURATION_US + INVISIBLE_DURATION_US, 0.f, nullptr },
+};
+
+constexpr Keyframe GAMEBOOT_KEYFRAMES[] =
+{
+	{ 0, 1.f, nullptr },
+	{ GB_FADE_OUT_START_TIME_US, 1.f, nullptr },
+	{ GB_ANIMATION_TOTAL_DURATION_US, 0.f, Ease::Linear },
+};
+
+constexpr Timeline PULSE_TIMELINE(PULSE_KEYFRAMES, true);
+constexpr Timeline GAMEBOOT_TIMELINE(GAMEBOOT_KEYFRAMES, false);
 
 bool LoadIpText()
 {
-	const char* ipTextPath = "/dev_flash/vsh/resource/explore/xmb/pro.xml";
-	char fileBuffer[512]{0};
-	if (!ReadFile(ipTextPath, fileBuffer, sizeof(fileBuffer)))
+	// pro.xml is streamed through in small chunks and reading stops as soon as the header element is closed,
+	// so the header can sit anywhere in a file of any size. A file without markup is the header as it is.
+	// Both buffers are static, this runs on a thread with a 2 KB stack
+	static char chunk[256];
+	static char headerBytes[sizeof(gIpBuffer) / sizeof(gIpBuffer[0]) * 3]; // UTF-8 is at most 3 bytes per BMP character
+	XmlValueExtractor extractor(PRO_XML_HEADER_ELEMENT, PRO_XML_HEADER_ATTRIBUTE, headerBytes, sizeof(headerBytes));
+	if (!StreamFile(PRO_XML_PATH, chunk, sizeof(chunk), extractor))
 		return false;
-	stdc::swprintf(gIpBuffer, 512, L"%s", fileBuffer);
-	system_plugin = paf::View::Find("system_plugin");
-	if (!system_plugin) return false;
-	page_notification = system_plugin->FindWidget("page_notification");
-	if (page_notification && page_notification->FindChild("ip_text", 0) != nullptr)
+
+	// a header that didn't fit ends in an ellipsis instead of stopping mid-word
+	constexpr size_t capacity = sizeof(gIpBuffer) / sizeof(gIpBuffer[0]);
+	Utf8::DecodeResult header = Utf8::Decode(headerBytes, extractor.GetLength(), gIpBuffer, capacity);
+	if (header.truncated || extractor.IsTruncated())
+	{
+		size_t end = header.written < capacity - 1 ? header.written : capacity - 2;
+		gIpBuffer[end] = L'…';
+		gIpBuffer[end + 1] = L'\0';
+	}
+
+	g_watcher.system_plugin = paf::View::Find("system_plugin");
+	if (!g_watcher.system_plugin) return false;
+	g_watcher.page_notification = g_watcher.system_plugin->FindWidget("page_notification");
+	if (g_watcher.page_notification && g_watcher.page_notification->FindChild("ip_text", 0) != nullptr)
 		gIsDebugXmbPlugin = true;
 	return true;
 }
 
-paf::PhWidget* GetParent() { if (!page_xmb_indicator) return nullptr; return page_xmb_indicator->FindChild("indicator", 0); }
-bool CanCreateIpText() { if (g_isIpTextDisabled) return false; paf::PhWidget* parent = GetParent(); return parent ? parent->FindChild("ip_text", 0) == nullptr : false; }
+bool CanCreateIpText() { if (g_isIpTextDisabled) return false; paf::PhWidget* parent = GetParent(); return parent ? (parent->FindChild("ip_text", 0) == nullptr || parent->FindChild("ip_text_header", 0) == nullptr) : false; }
 
-std::wstring GenerateIpText()
+// ===== SERVER TABLE =====
+// Revival networks are recognised by their DNS address, and the DNS probe's answers by the ranges listed for
+// them. The built-in list is the default; a "<dns address or network/prefix> <server name>" per line file on
+// /dev_hdd0 replaces it without a rebuild.
+constexpr const char* SERVER_TABLE_PATH = "/dev_hdd0/tmp/system_watcher_servers.txt";
+
+struct DefaultServer
 {
-	std::wstring text(gIpBuffer);
-	char ip[16]{0};
-	netctl::netctl_main_9A528B81(16, ip);
-	std::wstring systemIpAddress = L"System IP Address: ";
-	std::wstring IpAddress = (strlen(ip) > 0) ? std::wstring(ip, ip + strlen(ip)) : L"0.0.0.0";
-	std::wstring serverName;
-	if (IpAddress != L"0.0.0.0") {
-		xsetting_F48C0548_t* net = xsetting_F48C0548();
-		if (net) {
-			xsetting_F48C0548_t::net_info_t netInfo;
-			net->GetNetworkConfig(&netInfo);
-			std::wstring dnsPrimary(netInfo.primaryDns, netInfo.primaryDns + strlen(netInfo.primaryDns));
-			std::wstring dnsSecondary(netInfo.secondaryDns, netInfo.secondaryDns + strlen(netInfo.secondaryDns));
-			if (dnsPrimary == L"185.194.142.4" || dnsSecondary == L"185.194.142.4") serverName = L"PlayStation Online Network Emulated";
-			else if (dnsPrimary == L"51.79.41.185" || dnsSecondary == L"51.79.41.185") serverName = L"PlayStation Online Returnal Games";
-			else if (dnsPrimary == L"146.190.205.197" || dnsSecondary == L"146.190.205.197") serverName = L"PlayStation Reborn";
-			else if (dnsPrimary == L"135.148.144.253" || dnsSecondary == L"135.148.144.253") serverName = L"PlayStation Rewired";
-			else if (dnsPrimary == L"128.140.0.23" || dnsSecondary == L"128.140.0.23") serverName = L"Project Neptune";
-			else if (dnsPrimary == L"45.7.228.197" || dnsSecondary == L"45.7.228.197") serverName = L"Open Spy";
-			else if (dnsPrimary == L"142.93.245.186" || dnsSecondary == L"142.93.245.186") serverName = L"The ArchStones";
-			else if (dnsPrimary == L"188.225.75.35" || dnsSecondary == L"188.225.75.35") serverName = L"WareHouse";
-			else if (dnsPrimary == L"64.20.35.146" || dnsSecondary == L"64.20.35.146") serverName = L"Home Headquarters";
-			else if (dnsPrimary == L"52.86.120.101" || dnsSecondary == L"52.86.120.101") serverName = L"Destination Home";
-			else if (dnsPrimary == L"45.33.44.103" || dnsSecondary == L"45.33.44.103") serverName = L"Go Central";
-			else if (dnsPrimary == L"198.100.158.95" || dnsSecondary == L"198.100.158.95") serverName = L"Warhawk Revived";
-			else if (dnsPrimary == L"155.248.205.187" || dnsSecondary == L"155.248.202.187") serverName = L"Monster Hunter Frontier: Renewal";
-			else if (dnsPrimary == L"209.74.81.7" || dnsSecondary == L"209.74.81.7") serverName = L"Rocket NET";
-			else serverName = L"PlayStation™ Network";
+	const char* address; // a DNS server, or a range its network answers with
+	const wchar_t* name;
+};
+
+const DefaultServer g_defaultServers[] =
+{
+	{ "185.194.142.4", L"PlayStation Online Network Emulated" },
+	{ "51.79.41.185", L"PlayStation Online Returnal Games" },
+	{ "146.190.205.197", L"PlayStation Reborn" },
+	{ "135.148.144.253", L"PlayStation Rewired" },
+	{ "128.140.0.23", L"Project Neptune" },
+	{ "45.7.228.197", L"Open Spy" },
+	{ "142.93.245.186", L"The ArchStones" },
+	{ "188.225.75.35", L"WareHouse" },
+	{ "64.20.35.146", L"Home Headquarters" },
+	{ "52.86.120.101", L"Destination Home" },
+	{ "45.33.44.103", L"Go Central" },
+	{ "198.100.158.95", L"Warhawk Revived" },
+	{ "155.248.205.187", L"Monster Hunter Frontier: Renewal" },
+	{ "209.74.81.7", L"Rocket NET" },
+
+	// the hosts each network has been seen answering with sit in its DNS server's /24
+	{ "185.194.142.0/24", L"PlayStation Online Network Emulated" },
+	{ "51.79.41.0/24", L"PlayStation Online Returnal Games" },
+	{ "146.190.205.0/24", L"PlayStation Reborn" },
+	{ "135.148.144.0/24", L"PlayStation Rewired" },
+	{ "128.140.0.0/24", L"Project Neptune" },
+	{ "45.7.228.0/24", L"Open Spy" },
+	{ "142.93.245.0/24", L"The ArchStones" },
+	{ "188.225.75.0/24", L"WareHouse" },
+	{ "64.20.35.0/24", L"Home Headquarters" },
+	{ "52.86.120.0/24", L"Destination Home" },
+	{ "45.33.44.0/24", L"Go Central" },
+	{ "198.100.158.0/24", L"Warhawk Revived" },
+	{ "155.248.205.0/24", L"Monster Hunter Frontier: Renewal" },
+	{ "209.74.81.0/24", L"Rocket NET" },
+};
+
+// the built-in list is 28 entries and a replacement file a few dozen at most; anything past this is reported
+// as dropped when the file is loaded. A longer list only needs these raised
+constexpr size_t SERVER_TABLE_CAPACITY = 64;
+constexpr size_t SERVER_NAME_POOL_SIZE = 2048; // wchar_t units, 32 per entry on average
+
+FixedServerTable<SERVER_TABLE_CAPACITY, SERVER_NAME_POOL_SIZE> g_serverTable;
+
+void LoadServerTable()
+{
+	// static, this runs on a thread with a 2 KB stack
+	static char chunk[256];
+
+	g_serverTable.Clear();
+	if (StreamFile(SERVER_TABLE_PATH, chunk, sizeof(chunk), g_serverTable) && g_serverTable.GetCount() > 0)
+	{
+		// a table that got cut short would quietly misname networks, say so once
+		if (uint32_t dropped = g_serverTable.GetDroppedCount())
+		{
+			char message[128];
+			stdc::snprintf(message, sizeof(message), "System Watcher: %u server entries didn't fit and were skipped", dropped);
+			vshtask::Notify(message);
 		}
+		return;
 	}
-	systemIpAddress += IpAddress;
-	text += L"\n";
-	if (!serverName.empty()) text += L"Online Server: " + serverName + L"\n";
-	text += systemIpAddress;
-	return text;
+
+	g_serverTable.Clear();
+	for (const DefaultServer& server : g_defaultServers)
+	{
+		uint32_t network, prefixLength;
+		if (ServerTable::ParseCidr(server.address, strlen(server.address), network, prefixLength))
+			g_serverTable.AddRange(network, prefixLength, server.name);
+	}
+}
+
+// ip_text is anchored by its bottom line and grows upwards. ip_text_header sits on the same anchor, lifted by
+// one line per line of ip_text plus a blank one, so its layout only changes when the line count does.
+// Both widgets are styled alike, so the header's own text renderer gives the line pitch ip_text is laid out
+// with; the text size only stands in until the renderer exists.
+constexpr int IP_TEXT_SIZE = 34;
+constexpr float IP_TEXT_X = 820.f;
+constexpr float IP_TEXT_Y = -465.f;
+
+float GetIpTextLinePitch(paf::PhWidget* widget)
+{
+	paf::PhWidget::PhSRenderer* renderer = widget->m_Data.renderer;
+	if (!renderer || !renderer->sText)
+		return static_cast<float>(IP_TEXT_SIZE);
+
+	float height = 0.f, spacing = 0.f;
+	renderer->sText->GetStyle(paf::PhSText::LineHeight, height);
+	renderer->sText->GetStyle(paf::PhSText::LineSpacing, spacing);
+	return height > 0.f ? height + spacing : static_cast<float>(IP_TEXT_SIZE);
+}
+
+void SetIpTextLayoutPos(paf::PhWidget* widget, uint32_t liftLines)
+{
+	float lift = liftLines ? liftLines * GetIpTextLinePitch(widget) : 0.f;
+	widget->SetLayoutPos(0x60000, 0x50000, 0, { IP_TEXT_X, IP_TEXT_Y + lift, 0.f, 0.f });
 }
 
 void CreateIpText()
@@ -184,194 +272,1430 @@ void CreateIpText()
 	if (!parent)
 		return;
 
-	paf::PhText* ip_text = new paf::PhText(parent, nullptr);
-	if (!ip_text)
+	// the header is moved above ip_text once the first text is applied, see ApplyIpTextSnapshot()
+	for (const char* name : { "ip_text_header", "ip_text" })
+	{
+		if (parent->FindChild(name, 0))
+			continue;
+
+		paf::PhText* text = new paf::PhText(parent, nullptr);
+		if (!text)
+			return;
+
+		text->SetName(name);
+		text->SetColor({ 1.f, 1.f, 1.f, 1.f });
+		text->SetStyle(19, 112);
+		SetIpTextLayoutPos(text, 0);
+		text->SetLayoutStyle(0, 20, 0.f);
+		text->SetLayoutStyle(1, 217, 0.f);
+		text->SetStyle(56, true);
+		text->SetStyle(18, IP_TEXT_SIZE);
+		text->SetStyle(49, 2);
+	}
+
+	// the new widgets may sit at an address the cache remembers from a deleted one
+	InvalidateWidgetCache();
+}
+
+// ===== NETWORK WATCHER =====
+// the IP text only changes when the network does, the publisher and the probes key off its serial
+NetworkWatcher g_networkWatcher(netctl::netctl_main_953F1E14, netctl::netctl_main_A111D8FB, netctl::netctl_main_EC73B49D);
+
+void StartNetworkWatcher() { g_networkWatcher.Start(); }
+void StopNetworkWatcher() { g_networkWatcher.Stop(); }
+
+// fallback for when the handler couldn't be registered, called once per watcher pass
+void PollNetworkState() { g_networkWatcher.Poll(); }
+
+// ===== DNS PROBE =====
+// Matching the configured DNS address misses setups where a router or a Pi-hole forwards to a revival
+// server. The probe thread resolves a few PSN hostnames instead and classifies the answers against the
+// server table. gethostbyname() blocks for as long as the resolver keeps retrying, so it only ever runs on
+// that thread, and the watcher aborts any lookup that outlives DNS_LOOKUP_TIMEOUT_US. The watcher reads a
+// published verdict, which is dropped on a new network and expires a timeout after the next probe was due.
+constexpr const char* DNS_PROBE_HOSTS[] = { "a0.ww.np.dl.playstation.net", "auth.np.ac.playstation.net", "getprof.np.community.playstation.net" };
+constexpr uint64_t DNS_PROBE_TTL_US = 10 * 60 * 1000000ull;
+constexpr uint64_t DNS_PROBE_RETRY_US = 30 * 1000000ull; // nothing usable came back, try again soon
+constexpr uint64_t DNS_LOOKUP_TIMEOUT_US = 5 * 1000000ull;
+constexpr uint64_t DNS_PROBE_TIMEOUT_US = 15 * 1000000ull; // every host timing out
+
+struct DnsProbeVerdict
+{
+	const wchar_t* name;       // server table entry, nullptr when the answers looked like PSN
+	uint32_t address;          // answer the verdict was drawn from, 0 when nothing usable came back
+	uint32_t networkSerial;    // network the probe ran on
+	uint64_t expiresAt_us;     // 0 until the first publish
+};
+
+DoubleBuffer<DnsProbeVerdict> g_dnsProbeVerdict; // written by the probe thread only
+volatile bool g_networkProbeRunning = false;
+uint64_t g_dnsLookupStartedAt_us = 0; // 0 while no lookup is in flight
+Thread g_networkProbeThread;
+
+// gethostbyname() returns early on the probe thread, with no answer
+void AbortDnsLookup()
+{
+	sys_net_abort_resolver(g_networkProbeThread.u64Id, 0);
+}
+
+// gethostbyname() with the watcher's timeout around it. Once the thread is stopping the remaining hosts get
+// no lookup and no answer
+hostent* ResolveDnsProbeHost(const char* host)
+{
+	if (!g_networkProbeRunning)
+		return nullptr;
+
+	g_dnsLookupStartedAt_us = sys_time_get_system_time();
+	hostent* entry = gethostbyname(host);
+	g_dnsLookupStartedAt_us = 0;
+	return entry;
+}
+
+void PublishDnsProbeVerdict(const wchar_t* name, uint32_t address, uint32_t networkSerial, uint64_t expiresAt_us)
+{
+	g_dnsProbeVerdict.Publish(DnsProbeVerdict{ name, address, networkSerial, expiresAt_us });
+}
+
+// watcher side of the lookup timeout. The compare and swap makes it one abort per lookup; should the lookup
+// complete in the moment before the abort lands, the next one fails early and the probe simply retries
+void AbortStalledDnsLookup(uint64_t now_us)
+{
+	uint64_t startedAt_us = g_dnsLookupStartedAt_us;
+	if (!startedAt_us || now_us - startedAt_us < DNS_LOOKUP_TIMEOUT_US)
 		return;
 
-	ip_text->SetName("ip_text");
-	ip_text->SetColor({ 1.f, 1.f, 1.f, 1.f });
-	ip_text->SetStyle(19, 112);
-	ip_text->SetLayoutPos(0x60000, 0x50000, 0, { 820.f, -465.f, 0.f, 0.f });
-	ip_text->SetLayoutStyle(0, 20, 0.f);
-	ip_text->SetLayoutStyle(1, 217, 0.f);
-	ip_text->SetStyle(56, true);
-	ip_text->SetStyle(18, 34);
-	ip_text->SetStyle(49, 2);
+	if (cellAtomicCompareAndSwap64(&g_dnsLookupStartedAt_us, startedAt_us, 0) == startedAt_us)
+		AbortDnsLookup();
 }
-// ===== HOOK =====
-Detour* pafWidgetDrawThis_Detour;
 
-int pafWidgetDrawThis_Hook(paf::PhWidget* _this, unsigned int r4, bool r5)
+// nullptr unless a verdict for the current network is still fresh
+const DnsProbeVerdict* GetDnsProbeVerdict(uint64_t now_us)
 {
-	sys_time_sec_t sec;
-	sys_time_nsec_t nsec;
-	sys_time_get_current_time(&sec, &nsec);
-	uint64_t currentTime_us = static_cast<uint64_t>(sec)* 1000000ULL + nsec / 1000;
+	const DnsProbeVerdict* verdict = g_dnsProbeVerdict.Get();
+	if (verdict->expiresAt_us == 0 || verdict->networkSerial != g_networkWatcher.GetSerial() || now_us >= verdict->expiresAt_us)
+		return nullptr;
 
-	if ((currentTime_us - g_lastIpTextCheckTime) > IP_TEXT_CHECK_INTERVAL_US) {
-		g_cachedIpText = GenerateIpText();
-		g_lastIpTextCheckTime = currentTime_us;
-	}
+	return verdict;
+}
 
-	if (!g_is_hen && (currentTime_us - g_lastClockCheckTime) > CLOCK_CHECK_INTERVAL_US) {
-		g_cachedClockState = GetClockState();
-		g_lastClockCheckTime = currentTime_us;
-	}
+// ===== PING PROBE =====
+// How close the online server is, see PingProbe. The probe thread runs it, the watcher sets the target
+// whenever it regenerates the text and only reads the published summary.
+constexpr uint64_t PING_INTERVAL_US = 5 * 1000000ull;
+constexpr int32_t PING_TIMEOUT_MS = 1000;
+constexpr uint16_t PING_PORT_DNS = 53;
+constexpr uint16_t PING_PORT_HTTP = 80;
 
-	if (_this)
+PingProbe g_pingProbe(PING_INTERVAL_US, PING_TIMEOUT_MS);
+
+// ===== PROBE THREAD =====
+// Both probes block in the network stack, so they share a thread of their own.
+// Nothing is probed while in game or without an IP.
+constexpr uint64_t NETWORK_PROBE_IDLE_MS = 500;
+constexpr unsigned int NETWORK_PROBE_STACK_SIZE = 0x4000; // the resolver needs more than the default thread stack
+
+void NetworkProbeThread()
+{
+	uint32_t probedSerial = 0;
+	uint64_t nextDnsProbe_us = 0;
+
+	while (g_networkProbeRunning && !g_watcher.stopping)
 	{
-		const char* widgetName = _this->m_Data.name.c_str();
+		if (g_watcher.quiescent)
+		{
+			WaitForXmb(0);
+			continue;
+		}
 
-		if (strncmp(widgetName, "ip_text", 7) == 0)
+		uint64_t now = sys_time_get_system_time();
+		uint32_t networkSerial = g_networkWatcher.GetSerial();
+		int state = CELL_NET_CTL_STATE_Disconnected;
+		if (netctl::netctl_main_EC73B49D(&state) < 0 || state != CELL_NET_CTL_STATE_IPObtained)
 		{
-			paf::PhText* ip_text = (paf::PhText*)_this;
-			paf::PhWidget* parent = GetParent();
-			bool isParentVisible = parent && parent->m_Data.metaAlpha > 0.1f;
+			Timer::Sleep(NETWORK_PROBE_IDLE_MS);
+			continue;
+		}
 
-			if (g_isIpTextDisabled || vshmain::GetCooperationMode() == vshmain::CooperationMode::Game || !isParentVisible) {
-				ip_text->m_Data.metaAlpha = 0.f;
-			}
-			else {
-				ip_text->m_Data.metaAlpha = 1.f;
-			}
-			ip_text->SetText(g_cachedIpText, 0);
+		if (networkSerial != probedSerial || now >= nextDnsProbe_us)
+		{
+			DnsProbe::Result probe = DnsProbe::Run(DNS_PROBE_HOSTS, sizeof(DNS_PROBE_HOSTS) / sizeof(DNS_PROBE_HOSTS[0]), ResolveDnsProbeHost, g_serverTable);
+			if (!g_networkProbeRunning)
+				break;
+
+			probedSerial = networkSerial;
+			nextDnsProbe_us = now + (probe.address ? DNS_PROBE_TTL_US : DNS_PROBE_RETRY_US);
+			PublishDnsProbeVerdict(probe.name, probe.address, networkSerial, nextDnsProbe_us + DNS_PROBE_TIMEOUT_US);
+			now = sys_time_get_system_time();
 		}
 
-		// ===== GAMEBOOT ANIMATION  =====
-		if (!g_is_hen)
+		g_pingProbe.Run(now);
+		Timer::Sleep(NETWORK_PROBE_IDLE_MS);
+	}
+}
+
+void StartNetworkProbe()
+{
+	g_networkProbeRunning = true;
+	g_networkProbeThread = Thread(NetworkProbeThread, &g_networkProbeThread, "network_probe()", NETWORK_PROBE_STACK_SIZE);
+}
+
+// a lookup in flight is aborted, a ping handshake is short enough to wait out
+void StopNetworkProbe()
+{
+	if (!g_networkProbeRunning)
+		return;
+
+	g_networkProbeRunning = false;
+	AbortDnsLookup();
+	g_networkProbeThread.Join();
+}
+
+// ===== ONLINE SERVER =====
+// the configured DNS wins, the probe's verdict covers a router or Pi-hole forwarding to the server.
+// `target` receives where the ping probe should measure to
+const wchar_t* FindServerName(const char* dnsPrimary, const char* dnsSecondary, const DnsProbeVerdict* verdict, PingTarget& target)
+{
+	target = PingTarget{};
+	for (const char* dns : { dnsPrimary, dnsSecondary })
+	{
+		uint32_t address;
+		const wchar_t* name = ServerTable::ParseIpv4(dns, sizeof(address_t), address) ? g_serverTable.FindByDns(address) : nullptr;
+		if (name)
 		{
-			if (strncmp(widgetName, "enhanced_game_text", 18) == 0)
-			{
-				if (!g_gamebootAnimStarted)
-				{
-					g_cachedClockState = GetClockState();
-				}
-
-				bool shouldBeVisibleCondition = (g_cachedClockState == CLOCK_OVERCLOCK || g_cachedClockState == CLOCK_BALANCED);
-				float currentAlpha = 0.0f;
-
-				if (shouldBeVisibleCondition)
-				{
-					if (!g_gamebootAnimStarted)
-					{
-						g_gamebootAnimStarted = true;
-						g_gamebootAnimStartTime_us = currentTime_us;
-					}
-
-					uint64_t elapsed_us = currentTime_us - g_gamebootAnimStartTime_us;
-
-					if (elapsed_us < GB_FADE_OUT_START_TIME_US)
-					{
-						currentAlpha = 1.0f;
-					}
-					else if (elapsed_us < GB_ANIMATION_TOTAL_DURATION_US)
-					{
-						uint64_t fadeOut_elapsed_us = elapsed_us - GB_FADE_OUT_START_TIME_US;
-						currentAlpha = 1.0f - (static_cast<float>(fadeOut_elapsed_us) / GB_FADE_OUT_DURATION_US);
-					}
-					else
-					{
-						currentAlpha = 0.0f;
-						g_gamebootAnimStarted = false;
-					}
-				}
-				else
-				{
-					g_gamebootAnimStarted = false;
-					currentAlpha = 0.0f;
-				}
-
-				if (currentAlpha < 0.0f) currentAlpha = 0.0f;
-				if (currentAlpha > 1.0f) currentAlpha = 1.0f;
-
-				_this->m_Data.metaAlpha = currentAlpha;
-				_this->m_Data.colorScaleRGBA.a = currentAlpha;
-			}
+			target = PingTarget{ address, PING_PORT_DNS };
+			return name;
 		}
+	}
 
-		// ===== CLOCK STATE / LOGOS =====
-		if (!g_is_hen) {
-			if (strncmp(widgetName, "pslogo", 6) == 0 || strncmp(widgetName, "pslogo_ring", 11) == 0 ||
-				strncmp(widgetName, "performance_mode_text", 21) == 0 || strncmp(widgetName, "performance_mode_text_glow", 26) == 0 ||
-				strncmp(widgetName, "balanced_mode_text", 18) == 0 || strncmp(widgetName, "balanced_mode_text_glow", 23) == 0 ||
-				strncmp(widgetName, "power_saving_mode_text", 22) == 0 || strncmp(widgetName, "power_saving_mode_text_glow", 27) == 0)
-			{
-				paf::PhWidget* parent = GetParent();
-				bool parentVisible = parent && parent->m_Data.metaAlpha > 0.1f;
-
-				if (!parentVisible) {
-					_this->m_Data.metaAlpha = 0.f;
-				}
-				else {
-					float pslogoVis = 0.f, perfVis = 0.f, balVis = 0.f, powerVis = 0.f;
-
-					switch (g_cachedClockState) {
-					case CLOCK_OVERCLOCK: pslogoVis = 1.f; perfVis = 1.f; break;
-					case CLOCK_BALANCED:  pslogoVis = 1.f; balVis = 1.f; break;
-					case CLOCK_UNDERCLOCK: pslogoVis = 1.f; powerVis = 1.f; break;
-					default: break;
-					}
-
-					float pulseAlpha = 0.f;
-					if (pslogoVis > 0.1f) {
-						uint64_t elapsed_us = currentTime_us - g_animationStateChangeTime_us;
-						float progress = elapsed_us / static_cast<float>(FADE_DURATION_US);
-						if (progress > 1.f) progress = 1.f;
-
-						switch (g_animationState) {
-						case FADING_IN: pulseAlpha = progress;
-							if (elapsed_us >= FADE_DURATION_US) {
-								g_animationState = VISIBLE;
-								g_animationStateChangeTime_us = currentTime_us;
-							} break;
-
-						case VISIBLE: pulseAlpha = 1.f;
-							if (elapsed_us >= VISIBLE_DURATION_US) {
-								g_animationState = FADING_OUT;
-								g_animationStateChangeTime_us = currentTime_us;
-							} break;
-
-						case FADING_OUT: pulseAlpha = 1.f - progress;
-							if (elapsed_us >= FADE_DURATION_US) {
-								g_animationState = INVISIBLE;
-								g_animationStateChangeTime_us = currentTime_us;
-							} break;
-
-						case INVISIBLE: pulseAlpha = 0.f;
-							if (elapsed_us >= INVISIBLE_DURATION_US) {
-								g_animationState = FADING_IN;
-								g_animationStateChangeTime_us = currentTime_us;
-							} break;
-						}
-					}
-
-					if (strncmp(widgetName, "pslogo_ring", 11) == 0) _this->m_Data.colorScaleRGBA.a = pulseAlpha;
-					else if (strncmp(widgetName, "pslogo", 6) == 0) _this->m_Data.colorScaleRGBA.a = pslogoVis;
-					else if (strncmp(widgetName, "performance_mode_text_glow", 26) == 0) _this->m_Data.colorScaleRGBA.a = perfVis * pulseAlpha;
-					else if (strncmp(widgetName, "performance_mode_text", 21) == 0) _this->m_Data.colorScaleRGBA.a = perfVis;
-					else if (strncmp(widgetName, "balanced_mode_text_glow", 23) == 0) _this->m_Data.colorScaleRGBA.a = balVis * pulseAlpha;
-					else if (strncmp(widgetName, "balanced_mode_text", 18) == 0) _this->m_Data.colorScaleRGBA.a = balVis;
-					else if (strncmp(widgetName, "power_saving_mode_text_glow", 27) == 0) _this->m_Data.colorScaleRGBA.a = powerVis * pulseAlpha;
-					else if (strncmp(widgetName, "power_saving_mode_text", 22) == 0) _this->m_Data.colorScaleRGBA.a = powerVis;
-				}
-			}
+	if (verdict)
+	{
+		target = PingTarget{ verdict->address, PING_PORT_HTTP };
+		if (verdict->name)
+			return verdict->name;
+	}
+
+	return L"PlayStation™ Network";
+}
+
+// appends only the lines that can change, the pro.xml header is published separately
+void GenerateIpText(IpTextBuilder& text, const DnsProbeVerdict* verdict)
+{
+	char ip[16]{0};
+	netctl::netctl_main_9A528B81(16, ip);
+	bool hasIp = strlen(ip) > 0 && strcmp(ip, "0.0.0.0") != 0;
+
+	PingTarget target{};
+	if (hasIp) {
+		xsetting_F48C0548_t* net = xsetting_F48C0548();
+		if (net) {
+			xsetting_F48C0548_t::net_info_t netInfo;
+			net->GetNetworkConfig(&netInfo);
+			AppendServerLine(text, FindServerName(netInfo.primaryDns, netInfo.secondaryDns, verdict, target));
+
+			if (const PingSummary* ping = g_pingProbe.GetSummary(target))
+				AppendPingLine(text, ping->replies, ping->median_ms, ping->jitter_ms, ping->lossPercent);
 		}
 	}
+	g_pingProbe.SetTarget(target);
 
-	return pafWidgetDrawThis_Detour ? pafWidgetDrawThis_Detour->GetOriginal<int>(_this, r4, r5) : 0;
+	AppendAddressLine(text, hasIp ? ip : nullptr);
 }
 
-// ===== INSTALL / REMOVE =====
-void Install()
+// ===== IP TEXT PUBLISHER =====
+// GenerateIpText() goes through netctl and xsetting, far too slow for the render path, so the watcher
+// thread builds the text and IpTextPublisher hands the draw hook a snapshot of it.
+IpTextPublisher g_ipTextPublisher;
+uint32_t g_ipTextNetworkSerial = 0;
+uint32_t g_ipTextResumeSerial = 0;
+const DnsProbeVerdict* g_ipTextDnsProbeVerdict = nullptr;
+const PingSummary* g_ipTextPingSummary = nullptr;
+
+const IpTextSnapshot* GetIpTextSnapshot() { return g_ipTextPublisher.Get(); }
+
+void PublishIpText()
 {
-	g_is_hen = IsPayloadHen();
-	g_isIpTextDisabled = !IsIpTextEnabled();
-	LoadIpText();
-	pafWidgetDrawThis_Detour = new Detour(((opd_s*)paf::paf_63D446B8)->sub, pafWidgetDrawThis_Hook);
+	if (g_isIpTextDisabled)
+		return;
+
+	PollNetworkState();
+	AbortStalledDnsLookup(sys_time_get_system_time());
+
+	// also refresh when coming back from a game, a handler-less watcher can't have seen what happened meanwhile,
+	// and whenever one of the probes publishes or a DNS verdict goes stale
+	const IpTextSnapshot* current = g_ipTextPublisher.Get();
+	uint32_t networkSerial = g_networkWatcher.GetSerial();
+	const DnsProbeVerdict* verdict = GetDnsProbeVerdict(sys_time_get_system_time());
+	const PingSummary* ping = g_pingProbe.GetLatest();
+	if (current->version != 0 && g_ipTextNetworkSerial == networkSerial && g_ipTextResumeSerial == g_watcher.resumeSerial &&
+		g_ipTextDnsProbeVerdict == verdict && g_ipTextPingSummary == ping)
+		return;
+
+	g_ipTextNetworkSerial = networkSerial;
+	g_ipTextResumeSerial = g_watcher.resumeSerial;
+	g_ipTextDnsProbeVerdict = verdict;
+	g_ipTextPingSummary = ping;
+
+	// the debug plugin's own ip_text has no header widget next to it
+	IpTextBuilder& text = g_ipTextPublisher.Begin(gIpBuffer, gIsDebugXmbPlugin);
+	GenerateIpText(text, verdict);
+	g_ipTextPublisher.Publish();
 }
 
-void Remove()
+// ===== WIDGET CACHE =====
+WidgetRoleCache g_widgetRoleCache;
+
+void InvalidateWidgetCache() { g_watcher.widgetGeneration++; }
+
+// ===== PARENT CACHE =====
+// The "indicator" parent is asked for several times per frame, but it can only change together with
+// page_xmb_indicator or its plugin, and both bump the widget generation. The paf tree search therefore
+// only runs when the cached handle was resolved under another page or another generation.
+struct ParentCacheEntry
 {
-	if (pafWidgetDrawThis_Detour)
-		delete pafWidgetDrawThis_Detour;
+	paf::PhWidget* owner;
+	paf::PhWidget* parent;
+	uint32_t generation;
+};
+
+DoubleBuffer<ParentCacheEntry> g_parentCache;
+uint32_t g_parentCacheLock = 0;
+uint32_t g_findChildAvoided = 0; // debug builds only, see HOOK STATS
+
+void PublishParent(paf::PhWidget* owner, paf::PhWidget* parent, uint32_t generation)
+{
+	// the render thread and the watcher thread can both get here, whoever loses the race just doesn't cache
+	if (cellAtomicCompareAndSwap32(&g_parentCacheLock, 0, 1) != 0)
+		return;
+
+	g_parentCache.Publish(ParentCacheEntry{ owner, parent, generation });
+	g_parentCacheLock = 0;
+}
+
+paf::PhWidget* GetParent()
+{
+	paf::PhWidget* owner = g_watcher.page_xmb_indicator;
+	if (!owner)
+		return nullptr;
+
+	uint32_t generation = g_watcher.widgetGeneration;
+	const ParentCacheEntry* cached = g_parentCache.Get();
+	if (cached->owner == owner && cached->generation == generation)
+	{
+		if (HOOK_STATS_ENABLED)
+			cellAtomicIncr32(&g_findChildAvoided); // the render and watcher threads both count
+		return cached->parent;
+	}
+
+	// a missing indicator isn't cached, it may show up without the page changing
+	paf::PhWidget* parent = owner->FindChild("indicator", 0);
+	if (parent)
+		PublishParent(owner, parent, generation);
+
+	return parent;
+}
+
+
+WidgetRole ResolveWidgetRole(paf::PhWidget* widget)
+{
+	const std::string& widgetName = widget->m_Data.name;
+	size_t nameLength = widgetName.size();
+
+	WidgetRole role;
+	if (g_widgetRoleCache.Lookup(widget, widgetName.data(), nameLength, role))
+		return role;
+
+	role = WidgetRoles::Classify(widgetName.data(), nameLength);
+	g_widgetRoleCache.Insert(widget, widgetName.data(), nameLength, role);
+	return role;
+}
+
+// ===== COOPERATION MODE =====
+// vshmain_EB757101 is a cross-module call, but the mode only ever changes through SetCooperationMode or
+// ApplyCooperationMode. Both are hooked and the resulting mode is published here, so readers get a cached
+// value and anything that cares about transitions subscribes instead of polling.
+// vshmain can also switch modes internally without going through either export, so the watcher thread still
+// reads the mode once per pass and feeds it through the same path. That poll is the only source when the
+// exports can't be found; with the hooks in place it normally finds the mode unchanged and publishes nothing.
+constexpr uint32_t FNID_SET_COOPERATION_MODE = 0x45D85C54;
+constexpr uint32_t FNID_APPLY_COOPERATION_MODE = 0x5046CFAB;
+constexpr int MAX_COOPERATION_MODE_SUBSCRIBERS = 4;
+
+struct CooperationModeSnapshot
+{
+	vshmain::CooperationMode mode;
+	vshmain::CooperationMode previous;
+	uint64_t changedAt_us;
+	uint32_t serial; // 0 until the first publish
+};
+
+typedef void(*CooperationModeHandler)(const CooperationModeSnapshot& snapshot);
+
+DoubleBuffer<CooperationModeSnapshot> g_cooperationMode;
+uint32_t g_cooperationModeLock = 0;
+CooperationModeHandler g_cooperationModeSubscribers[MAX_COOPERATION_MODE_SUBSCRIBERS]{};
+bool g_cooperationModeHooked = false;
+ImportExportDetour* setCooperationMode_Detour = nullptr;
+ImportExportDetour* applyCooperationMode_Detour = nullptr;
+
+void PublishCooperationMode(vshmain::CooperationMode mode)
+{
+	// transitions are rare and must not be lost, so unlike the parent cache this one waits for the lock
+	while (cellAtomicCompareAndSwap32(&g_cooperationModeLock, 0, 1) != 0)
+		sys_ppu_thread_yield();
+
+	const CooperationModeSnapshot* current = g_cooperationMode.Get();
+	if (current->serial != 0 && current->mode == mode)
+	{
+		__lwsync();
+		g_cooperationModeLock = 0;
+		return;
+	}
+
+	CooperationModeSnapshot published{ mode, current->serial != 0 ? current->mode : mode, sys_time_get_system_time(), current->serial + 1 };
+	g_cooperationMode.Publish(published);
+	g_cooperationModeLock = 0;
+
+	for (int i = 0; i < MAX_COOPERATION_MODE_SUBSCRIBERS; i++)
+	{
+		CooperationModeHandler handler = g_cooperationModeSubscribers[i];
+		if (handler)
+			handler(published);
+	}
+}
+
+vshmain::CooperationMode GetCachedCooperationMode() { return g_cooperationMode.Get()->mode; }
+
+CooperationModeSnapshot GetCooperationModeSnapshot() { return g_cooperationMode.Read(); }
+
+bool SubscribeCooperationMode(CooperationModeHandler handler)
+{
+	for (int i = 0; i < MAX_COOPERATION_MODE_SUBSCRIBERS; i++)
+	{
+		if (!g_cooperationModeSubscribers[i])
+		{
+			g_cooperationModeSubscribers[i] = handler;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SetCooperationMode_Hook(vshmain::CooperationMode mode)
+{
+	setCooperationMode_Detour->GetOriginal<void>(mode);
+	PublishCooperationMode(vshmain::GetCooperationMode());
+}
+
+void ApplyCooperationMode_Hook()
+{
+	applyCooperationMode_Detour->GetOriginal<void>();
+	PublishCooperationMode(vshmain::GetCooperationMode());
+}
+
+void InstallCooperationModeHooks()
+{
+	PublishCooperationMode(vshmain::GetCooperationMode());
+
+	g_cooperationModeHooked = FindExportByName("vshmain", FNID_SET_COOPERATION_MODE) && FindExportByName("vshmain", FNID_APPLY_COOPERATION_MODE);
+	if (!g_cooperationModeHooked)
+		return;
+
+	setCooperationMode_Detour = new ImportExportDetour(ImportExportDetour::Export, "vshmain", FNID_SET_COOPERATION_MODE, reinterpret_cast<uintptr_t>(SetCooperationMode_Hook));
+	applyCooperationMode_Detour = new ImportExportDetour(ImportExportDetour::Export, "vshmain", FNID_APPLY_COOPERATION_MODE, reinterpret_cast<uintptr_t>(ApplyCooperationMode_Hook));
+}
+
+void RemoveCooperationModeHooks()
+{
+	g_cooperationModeHooked = false;
+
+	if (setCooperationMode_Detour)
+		delete setCooperationMode_Detour;
+	if (applyCooperationMode_Detour)
+		delete applyCooperationMode_Detour;
+
+	setCooperationMode_Detour = nullptr;
+	applyCooperationMode_Detour = nullptr;
+}
+
+// ===== FRAME STATE =====
+// Everything the per-widget handlers need is computed once per frame epoch instead of once per draw call.
+// A new epoch starts when FRAME_EPOCH_US of timebase has elapsed since the last one, which is well under
+// a 60Hz frame, so every widget drawn in the same frame reads the same state.
+constexpr uint64_t FRAME_EPOCH_US = 8000;
+
+struct FrameState
+{
+	uint64_t timebase;
+	uint64_t time_us;
+	bool parentVisible;
+	vshmain::CooperationMode cooperationMode;
+	float logoAlpha[LOGO_TARGET_COUNT]; // indexed by role - ROLE_PSLOGO
+};
+
+DoubleBuffer<FrameState> g_frameState; // written by whichever thread drives the frames, the draw hook or the bound controller
+
+void InitFrameClock()
+{
+	uint64_t frequency = sys_time_get_timebase_frequency();
+	g_render.timebaseTicksPerUs = static_cast<double>(frequency) / 1000000.0;
+	g_render.frameEpochTicks = static_cast<uint64_t>(FRAME_EPOCH_US * g_render.timebaseTicksPerUs);
+}
+
+// ===== HOOK STATS =====
+// Cost of our code inside the render path, rolled up per frame epoch so the hook modes can be compared.
+// Debug builds define SYSTEM_WATCHER_HOOK_STATS; in release the counters and the timebase reads compile out.
+constexpr uint64_t HOOK_STATS_WRITE_INTERVAL_US = 10000000;
+constexpr size_t HOOK_STATS_CLOCK_SAMPLES = 8;
+constexpr uint64_t HOOK_STATS_CLOCK_WINDOW_US = 60 * 1000000ull;
+
+HookStats g_hookStats{};
+
+void RollHookStats()
+{
+	if (!HOOK_STATS_ENABLED)
+		return;
+
+	g_hookStats.frames++;
+	g_hookStats.lastFrameCalls = g_render.frameCalls;
+	g_hookStats.lastFrameTargetCalls = g_render.frameTargetCalls;
+	g_hookStats.lastFrameTicks = g_render.frameTicks;
+	g_hookStats.totalTicks += g_render.frameTicks;
+	if (g_render.frameTicks > g_hookStats.maxFrameTicks)
+		g_hookStats.maxFrameTicks = g_render.frameTicks;
+
+	g_render.frameCalls = 0;
+	g_render.frameTargetCalls = 0;
+	g_render.frameTicks = 0;
+}
+
+void RecordHookCall(uint64_t enterTimebase, bool isTarget)
+{
+	if (!HOOK_STATS_ENABLED)
+		return;
+
+	uint64_t leaveTimebase;
+	SYS_TIMEBASE_GET(leaveTimebase);
+
+	g_render.frameCalls++;
+	if (isTarget)
+		g_render.frameTargetCalls++;
+	g_render.frameTicks += leaveTimebase - enterTimebase;
+}
+
+uint64_t g_hookStatsWrittenAt_us = 0;
+char g_hookStatsText[1024]; // static, the watcher thread runs on a small stack
+
+uint64_t TicksToUs(uint64_t ticks)
+{
+	return g_render.timebaseTicksPerUs > 0.0 ? static_cast<uint64_t>(ticks / g_render.timebaseTicksPerUs) : 0;
+}
+
+// Dumps the counters to /dev_hdd0/tmp every HOOK_STATS_WRITE_INTERVAL_US, called from the watcher thread.
+// They're read without any locking, so one dump can mix two frames.
+void WriteHookStats()
+{
+	if (!HOOK_STATS_ENABLED)
+		return;
+
+	uint64_t now_us = sys_time_get_system_time();
+	if (g_hookStatsWrittenAt_us && now_us - g_hookStatsWrittenAt_us < HOOK_STATS_WRITE_INTERVAL_US)
+		return;
+	g_hookStatsWrittenAt_us = now_us;
+
+	// the sampler's times are on the frame clock
+	uint64_t frame_us = GetFrameClock_us();
+	ClockWindowStats window;
+	g_clockSampler.GetWindowStats(frame_us, HOOK_STATS_CLOCK_WINDOW_US, window);
+	uint64_t sinceChange_us = 0;
+	g_clockSampler.GetTimeSinceChange(frame_us, sinceChange_us);
+
+	const HookStats& stats = g_hookStats;
+	int length = stdc::snprintf(g_hookStatsText, sizeof(g_hookStatsText),
+		"mode: %d\n"
+		"frames: %llu\n"
+		"last frame: %u calls, %u targets, %llu us\n"
+		"frame cost: %llu us avg, %llu us max\n"
+		"SetText: %u issued, %llu skipped\n"
+		"gameboot: %u draws, %llu us avg, %llu us max\n"
+		"FindChild avoided: %u\n"
+		"clock: %u MHz core, %u MHz vram, state %d\n"
+		"clock sampler: %llu peeks, %u samples, %u rejected, %llu ms interval\n"
+		"clock last min: %u samples, core %u-%u MHz (avg %u), vram %u-%u MHz (avg %u)\n"
+		"clock changed: %llu s ago\n"
+		"servers: %u loaded, %u dropped\n",
+		static_cast<int>(stats.mode),
+		static_cast<unsigned long long>(stats.frames),
+		stats.lastFrameCalls, stats.lastFrameTargetCalls, static_cast<unsigned long long>(TicksToUs(stats.lastFrameTicks)),
+		static_cast<unsigned long long>(stats.frames ? TicksToUs(stats.totalTicks) / stats.frames : 0), static_cast<unsigned long long>(TicksToUs(stats.maxFrameTicks)),
+		stats.setTextCalls, static_cast<unsigned long long>(stats.setTextSkipped),
+		stats.gamebootCalls, static_cast<unsigned long long>(stats.gamebootCalls ? TicksToUs(stats.gamebootTicks) / stats.gamebootCalls : 0), static_cast<unsigned long long>(TicksToUs(stats.gamebootMaxTicks)),
+		g_findChildAvoided,
+		g_clockSampler.GetCoreMHz(), g_clockSampler.GetVramMHz(), static_cast<int>(g_clockSampler.GetState()),
+		static_cast<unsigned long long>(g_clockSampler.GetPeekCount()), g_clockSampler.GetSampleCount(), g_clockSampler.GetRejectedCount(),
+		static_cast<unsigned long long>(g_clockSampler.GetInterval() / 1000),
+		window.samples, window.coreMin_MHz, window.coreMax_MHz, window.coreAvg_MHz, window.vramMin_MHz, window.vramMax_MHz, window.vramAvg_MHz,
+		static_cast<unsigned long long>(sinceChange_us / 1000000),
+		static_cast<uint32_t>(g_serverTable.GetCount()), g_serverTable.GetDroppedCount());
+
+	if (length <= 0)
+		return;
+	if (length >= static_cast<int>(sizeof(g_hookStatsText)))
+		length = sizeof(g_hookStatsText) - 1;
+
+	// the last few samples as they were taken, odd ones included, newest first
+	static ClockSample samples[HOOK_STATS_CLOCK_SAMPLES];
+	size_t count = g_clockSampler.GetRecentSamples(samples, HOOK_STATS_CLOCK_SAMPLES);
+	for (size_t i = 0; i < count; i++)
+	{
+		int written = stdc::snprintf(g_hookStatsText + length, sizeof(g_hookStatsText) - length, "clock sample: %u/%u MHz %llu s ago\n",
+			samples[i].reading.core_MHz, samples[i].reading.vram_MHz,
+			static_cast<unsigned long long>(frame_us > samples[i].time_us ? (frame_us - samples[i].time_us) / 1000000 : 0));
+		if (written <= 0 || length + written >= static_cast<int>(sizeof(g_hookStatsText)))
+			break;
+		length += written;
+	}
+
+	int fd;
+	if (cellFsOpen("/dev_hdd0/tmp/system_watcher_stats.txt", CELL_FS_O_WRONLY | CELL_FS_O_CREAT | CELL_FS_O_TRUNC, &fd, nullptr, 0) != CELL_FS_SUCCEEDED)
+		return;
+
+	cellFsWrite(fd, g_hookStatsText, length, nullptr);
+	cellFsClose(fd);
+}
+
+// the draw hook passes GetParent(), the bound controller the parent the watcher thread resolved for it
+template<bool IsHen>
+void BeginFrame(uint64_t timebase, paf::PhWidget* parent)
+{
+	RollHookStats();
+
+	FrameState& frame = g_frameState.Next();
+	frame.timebase = timebase;
+	frame.time_us = static_cast<uint64_t>(timebase / g_render.timebaseTicksPerUs);
+
+	// back from a game: the clock state went stale while we were quiescent, don't wait out the interval
+	if (g_render.resumeSerial != g_watcher.resumeSerial)
+	{
+		g_render.resumeSerial = g_watcher.resumeSerial;
+		g_clockSampler.Tighten();
+	}
+
+	frame.cooperationMode = GetCachedCooperationMode();
+
+	// while a game boots the prefetch thread owns the peeks, the render thread only reads
+	if (!IsHen)
+	{
+		if (frame.cooperationMode != vshmain::CooperationMode::Game)
+			g_clockSampler.Update(frame.time_us);
+		g_render.cachedClockState = g_clockSampler.GetState();
+	}
+
+	frame.parentVisible = parent && parent->m_Data.metaAlpha > 0.1f;
+
+	if (!IsHen)
+		ComputeLogoAlphas(frame.logoAlpha, g_render.cachedClockState, frame.parentVisible, frame.time_us, PULSE_TIMELINE, g_render.pulse);
+
+	g_frameState.Publish();
+}
+
+template<bool IsHen>
+const FrameState& GetFrameState(uint64_t timebase)
+{
+	if (timebase - g_frameState.Get()->timebase >= g_render.frameEpochTicks)
+		BeginFrame<IsHen>(timebase, GetParent());
+
+	return *g_frameState.Get();
+}
+
+// ===== HOOK =====
+Detour* pafWidgetDrawThis_Detour;
+HookMode g_hookMode = HookMode::GlobalDetour;
+
+typedef int(*DrawThisHook)(paf::PhWidget* _this, unsigned int r4, bool r5);
+
+template<bool IpTextDisabled>
+void ApplyIpTextVisibility(paf::PhWidget* ip_text, const FrameState& frame)
+{
+	if (IpTextDisabled || frame.cooperationMode == vshmain::CooperationMode::Game || !frame.parentVisible) {
+		ip_text->m_Data.metaAlpha = 0.f;
+	}
+	else {
+		ip_text->m_Data.metaAlpha = 1.f;
+	}
+}
+
+// SetText() copies the string and makes paf lay the glyphs out again, so it's only issued when the widget
+// isn't already showing the published version
+struct AppliedText
+{
+	paf::PhWidget* widget;
+	uint32_t generation;
+	uint32_t version;
+};
+
+AppliedText g_appliedIpText{};
+AppliedText g_appliedIpTextHeader{};
+
+bool IsApplied(const AppliedText& applied, paf::PhWidget* widget, uint32_t version)
+{
+	return applied.widget == widget && applied.generation == g_watcher.widgetGeneration && applied.version == version;
+}
+
+void ApplyText(paf::PhWidget* widget, AppliedText& applied, const std::wstring& text, uint32_t version)
+{
+	uint32_t generation = g_watcher.widgetGeneration;
+	if (applied.widget == widget && applied.generation == generation && applied.version == version)
+	{
+		if (HOOK_STATS_ENABLED)
+			g_hookStats.setTextSkipped++;
+		return;
+	}
+
+	((paf::PhText*)widget)->SetText(text, 0);
+	applied = AppliedText{ widget, generation, version };
+	if (HOOK_STATS_ENABLED)
+		g_hookStats.setTextCalls++;
+}
+
+void ApplyIpTextSnapshot(paf::PhWidget* widget, WidgetRole role)
+{
+	const IpTextSnapshot* snapshot = GetIpTextSnapshot();
+	if (role == ROLE_IP_TEXT_HEADER)
+	{
+		if (!IsApplied(g_appliedIpTextHeader, widget, snapshot->headerVersion))
+			SetIpTextLayoutPos(widget, snapshot->headerLift);
+		ApplyText(widget, g_appliedIpTextHeader, snapshot->header, snapshot->headerVersion);
+	}
+	else
+		ApplyText(widget, g_appliedIpText, snapshot->text, snapshot->version);
+}
+
+template<bool IpTextDisabled>
+void HandleIpText(paf::PhWidget* widget, WidgetRole role, const FrameState& frame)
+{
+	ApplyIpTextVisibility<IpTextDisabled>(widget, frame);
+	ApplyIpTextSnapshot(widget, role);
+}
+
+// ===== CLOCK PREFETCH =====
+// A game launch is when the gameboot text needs a fresh clock state, and also when the render thread can
+// least afford two hypervisor peeks. The launch is caught on the cooperation mode change, or failing that
+// on the gameboot text's first draw, and a parked thread takes the reading so the draw only copies it.
+// The thread stamps what it took with the launch's serial, and the text holds off until it sees the stamp.
+constexpr uint64_t CLOCK_PREFETCH_BIT = 1;
+
+sys_event_flag_t g_clockPrefetchFlag = SYS_EVENT_FLAG_ID_INVALID;
+volatile bool g_clockPrefetchRunning = false;
+volatile uint32_t g_clockPrefetchSerial = 0;   // cooperation mode serial of the launch last prefetched for
+volatile uint32_t g_clockPrefetchedSerial = 0; // the one whose prefetch has been published
+Thread g_clockPrefetchThread;
+
+// cheap enough for the draw hook, it only makes the syscall once per launch
+void RequestClockPrefetch(uint32_t serial)
+{
+	if (g_clockPrefetchSerial == serial || g_clockPrefetchFlag == SYS_EVENT_FLAG_ID_INVALID)
+		return;
+
+	g_clockPrefetchSerial = serial;
+	sys_event_flag_set(g_clockPrefetchFlag, CLOCK_PREFETCH_BIT);
+}
+
+bool IsClockPrefetched(uint32_t serial) { return g_clockPrefetchedSerial == serial; }
+
+void PrefetchClock()
+{
+	uint32_t serial = g_clockPrefetchSerial;
+
+	// a reading that differs from the published one has to be confirmed before the gameboot text sees it,
+	// and the text is waiting, so the confirming peeks are taken back to back rather than an interval apart
+	for (uint32_t i = 0; i < ClockSampler::ConfirmSamples && g_clockPrefetchRunning; i++)
+	{
+		g_clockSampler.Tighten();
+		g_clockSampler.Update(GetFrameClock_us());
+		if (!g_clockSampler.IsConfirming())
+			break;
+	}
+
+	__lwsync();
+	g_clockPrefetchedSerial = serial;
+}
+
+void ClockPrefetchThread()
+{
+	while (g_clockPrefetchRunning)
+	{
+		uint64_t result;
+		if (sys_event_flag_wait(g_clockPrefetchFlag, CLOCK_PREFETCH_BIT, SYS_EVENT_FLAG_WAIT_AND | SYS_EVENT_FLAG_WAIT_CLEAR, &result, 0) != CELL_OK)
+			break;
+
+		if (g_clockPrefetchRunning)
+			PrefetchClock();
+	}
+}
+
+void StartClockPrefetch()
+{
+	sys_event_flag_attribute_t attr;
+	sys_event_flag_attribute_initialize(attr);
+	attr.type = SYS_SYNC_WAITER_SINGLE;
+	sys_event_flag_attribute_name_set(attr.name, "swClkPf");
+
+	if (sys_event_flag_create(&g_clockPrefetchFlag, &attr, 0) != CELL_OK)
+	{
+		// no thread to hand the peeks to, the render thread keeps sampling on its own
+		g_clockPrefetchFlag = SYS_EVENT_FLAG_ID_INVALID;
+		return;
+	}
+
+	g_clockPrefetchRunning = true;
+	g_clockPrefetchThread = Thread(ClockPrefetchThread, &g_clockPrefetchThread, "clock_prefetch()");
+}
+
+void StopClockPrefetch()
+{
+	if (!g_clockPrefetchRunning)
+		return;
+
+	g_clockPrefetchRunning = false;
+	sys_event_flag_set(g_clockPrefetchFlag, CLOCK_PREFETCH_BIT);
+	g_clockPrefetchThread.Join();
+
+	sys_event_flag_t flag = g_clockPrefetchFlag;
+	g_clockPrefetchFlag = SYS_EVENT_FLAG_ID_INVALID;
+	sys_event_flag_destroy(flag);
+}
+
+// Clocks are most likely to change around a game launch or exit. Launching prefetches for the gameboot
+// text, anything else has the sampler start over at its shortest interval.
+void OnClockModeChanged(const CooperationModeSnapshot& snapshot)
+{
+	if (snapshot.mode == vshmain::CooperationMode::Game)
+		RequestClockPrefetch(snapshot.serial);
+	else
+		g_clockSampler.Tighten();
+}
+
+// ===== GAMEBOOT ANIMATION  =====
+void RecordGamebootCall(uint64_t enterTimebase)
+{
+	if (!HOOK_STATS_ENABLED)
+		return;
+
+	uint64_t leaveTimebase;
+	SYS_TIMEBASE_GET(leaveTimebase);
+
+	uint64_t ticks = leaveTimebase - enterTimebase;
+	g_hookStats.gamebootCalls++;
+	g_hookStats.gamebootTicks += ticks;
+	if (ticks > g_hookStats.gamebootMaxTicks)
+		g_hookStats.gamebootMaxTicks = ticks;
+}
+
+void AnimateGamebootText(paf::PhWidget* widget, const FrameState& frame)
+{
+	// the text's first draw for a launch stands in for a cooperation mode change that hasn't been seen yet,
+	// the state itself is only ever read here. It stays hidden until the launch's prefetch is published, or
+	// GB_CLOCK_WAIT_US has passed without one
+	if (!g_render.gamebootAnimStarted)
+	{
+		if (g_clockPrefetchFlag == SYS_EVENT_FLAG_ID_INVALID)
+			g_clockSampler.Update(frame.time_us);
+		else
+		{
+			uint32_t serial = g_cooperationMode.Get()->serial;
+			RequestClockPrefetch(serial);
+			if (g_render.gamebootClockSerial != serial)
+			{
+				g_render.gamebootClockSerial = serial;
+				g_render.gamebootClockWaitStart_us = frame.time_us;
+			}
+
+			if (!IsClockPrefetched(serial) && frame.time_us - g_render.gamebootClockWaitStart_us < GB_CLOCK_WAIT_US)
+			{
+				widget->m_Data.metaAlpha = 0.0f;
+				widget->m_Data.colorScaleRGBA.a = 0.0f;
+				return;
+			}
+		}
+
+		g_render.cachedClockState = g_clockSampler.GetState();
+	}
+
+	bool shouldBeVisibleCondition = (g_render.cachedClockState == CLOCK_OVERCLOCK || g_render.cachedClockState == CLOCK_BALANCED);
+	float currentAlpha = 0.0f;
+
+	if (shouldBeVisibleCondition)
+	{
+		if (!g_render.gamebootAnimStarted)
+		{
+			g_render.gamebootAnimStarted = true;
+			g_render.gamebootAnimStartTime_us = frame.time_us;
+		}
+
+		if (GAMEBOOT_TIMELINE.GetSegment(g_render.gamebootAnimStartTime_us, frame.time_us) != Timeline::Finished)
+		{
+			currentAlpha = GAMEBOOT_TIMELINE.Evaluate(g_render.gamebootAnimStartTime_us, frame.time_us);
+		}
+		else
+		{
+			currentAlpha = 0.0f;
+			g_render.gamebootAnimStarted = false;
+		}
+	}
+	else
+	{
+		g_render.gamebootAnimStarted = false;
+		currentAlpha = 0.0f;
+	}
+
+	if (currentAlpha < 0.0f) currentAlpha = 0.0f;
+	if (currentAlpha > 1.0f) currentAlpha = 1.0f;
+
+	widget->m_Data.metaAlpha = currentAlpha;
+	widget->m_Data.colorScaleRGBA.a = currentAlpha;
+}
+
+void HandleGamebootText(paf::PhWidget* widget, WidgetRole role, const FrameState& frame)
+{
+	uint64_t enterTimebase = 0;
+	if (HOOK_STATS_ENABLED)
+		SYS_TIMEBASE_GET(enterTimebase);
+
+	AnimateGamebootText(widget, frame);
+	RecordGamebootCall(enterTimebase);
+}
+
+// ===== CLOCK STATE / LOGOS =====
+void HandleClockLogo(paf::PhWidget* widget, WidgetRole role, const FrameState& frame)
+{
+	if (!frame.parentVisible) {
+		widget->m_Data.metaAlpha = 0.f;
+		return;
+	}
+
+	widget->m_Data.colorScaleRGBA.a = frame.logoAlpha[role - ROLE_PSLOGO];
+}
+
+struct PafWidgetHandlers
+{
+	template<bool IpTextDisabled>
+	static void IpText(paf::PhWidget* widget, WidgetRole role, const FrameState& frame) { HandleIpText<IpTextDisabled>(widget, role, frame); }
+	static void GamebootText(paf::PhWidget* widget, WidgetRole role, const FrameState& frame) { HandleGamebootText(widget, role, frame); }
+	static void ClockLogo(paf::PhWidget* widget, WidgetRole role, const FrameState& frame) { HandleClockLogo(widget, role, frame); }
+};
+
+// gIsDebugXmbPlugin is only consulted by CreateIpText() on the watcher thread, the hook never reads it
+template<bool IsHen, bool IpTextDisabled>
+int pafWidgetDrawThis_Hook(paf::PhWidget* _this, unsigned int r4, bool r5)
+{
+	if (g_watcher.quiescent)
+		return pafWidgetDrawThis_Detour->GetOriginal<int>(_this, r4, r5);
+
+	uint64_t timebase;
+	SYS_TIMEBASE_GET(timebase);
+
+	const FrameState& frame = GetFrameState<IsHen>(timebase);
+	WidgetRole role = ROLE_NONE;
+
+	if (_this)
+	{
+		g_widgetRoleCache.Sync(g_watcher.widgetGeneration);
+		role = ResolveWidgetRole(_this);
+
+		if (role != ROLE_NONE)
+			DispatchWidget<IsHen, IpTextDisabled, PafWidgetHandlers>(_this, role, frame);
+	}
+
+	RecordHookCall(timebase, role != ROLE_NONE);
+	return pafWidgetDrawThis_Detour ? pafWidgetDrawThis_Detour->GetOriginal<int>(_this, r4, r5) : 0;
+}
+
+// ===== VTABLE SWAP =====
+// Alternative to the global detour: each target widget gets its own copy of its vtable with the DrawThis
+// slot pointing at us, so the rest of the VSH UI draws without ever entering our code.
+// The copy starts PHWIDGET_VTABLE_PREFIX words before the address point, so the offset-to-top and RTTI
+// words that precede it are still there for anything that looks at the widget's dynamic type.
+constexpr int PHWIDGET_VTABLE_PREFIX = 2;
+constexpr int PHWIDGET_VTABLE_SIZE = 81;
+constexpr int PHWIDGET_DRAWTHIS_SLOT = 38;
+
+struct VtableClone
+{
+	void* prefix[PHWIDGET_VTABLE_PREFIX];
+	void* entries[PHWIDGET_VTABLE_SIZE]; // m_Data.vtable points here
+	paf::_vtable* original;
+	paf::PhWidget* widget;
+	uint32_t generation; // widgetGeneration the widget was last found in
+	WidgetRole role;
+};
+
+VtableClone g_vtableClones[ROLE_COUNT]{}; // target names are unique, so one clone per role
+DrawThisHook g_swappedDrawThis_Hook = nullptr;
+
+paf::_vtable* AddressPointOf(VtableClone& clone)
+{
+	return reinterpret_cast<paf::_vtable*>(clone.entries);
+}
+
+VtableClone* CloneOf(paf::_vtable* vtable)
+{
+	return reinterpret_cast<VtableClone*>(reinterpret_cast<char*>(vtable) - offsetof(VtableClone, entries));
+}
+
+template<bool IsHen, bool IpTextDisabled>
+int SwappedDrawThis_Hook(paf::PhWidget* _this, unsigned int r4, bool r5)
+{
+	VtableClone* clone = CloneOf(_this->m_Data.vtable);
+	if (g_watcher.quiescent)
+		return clone->original->CallMethod<int>(PHWIDGET_DRAWTHIS_SLOT, _this, r4, r5);
+
+	uint64_t timebase;
+	SYS_TIMEBASE_GET(timebase);
+
+	const FrameState& frame = GetFrameState<IsHen>(timebase);
+
+	DispatchWidget<IsHen, IpTextDisabled, PafWidgetHandlers>(_this, clone->role, frame);
+
+	RecordHookCall(timebase, true);
+	return clone->original->CallMethod<int>(PHWIDGET_DRAWTHIS_SLOT, _this, r4, r5);
+}
+
+paf::PhWidget* FindTargetWidget(const char* name)
+{
+	paf::PhWidget* widget = nullptr;
+
+	paf::PhWidget* parent = GetParent();
+	if (parent)
+		widget = parent->FindChild(name, 0);
+
+	if (!widget && g_watcher.page_xmb_indicator)
+		widget = g_watcher.page_xmb_indicator->FindChild(name, 0);
+
+	if (!widget && g_watcher.xmb_plugin)
+		widget = g_watcher.xmb_plugin->FindWidget(name);
+
+	if (!widget && g_watcher.system_plugin)
+		widget = g_watcher.system_plugin->FindWidget(name);
+
+	return widget;
+}
+
+void SwapWidgetVtable(VtableClone& clone, paf::PhWidget* widget, WidgetRole role)
+{
+	paf::_vtable* original = widget->m_Data.vtable;
+	stdc::memcpy(clone.prefix, reinterpret_cast<void**>(original) - PHWIDGET_VTABLE_PREFIX, sizeof(clone.prefix) + sizeof(clone.entries));
+	clone.entries[PHWIDGET_DRAWTHIS_SLOT] = reinterpret_cast<void*>(g_swappedDrawThis_Hook);
+	clone.original = original;
+	clone.widget = widget;
+	clone.generation = g_watcher.widgetGeneration;
+	clone.role = role;
+
+	// the render thread may draw this widget at any time, publish the clone only once it is complete
+	__lwsync();
+	widget->m_Data.vtable = AddressPointOf(clone);
+}
+
+void BindSwappedWidgets(uint32_t roles)
+{
+	for (int role = ROLE_NONE + 1; role < ROLE_COUNT; role++)
+	{
+		if (!(roles & WidgetRoles::RoleBit(static_cast<WidgetRole>(role))))
+			continue;
+
+		paf::PhWidget* widget = FindTargetWidget(WidgetRoles::NameOf(static_cast<WidgetRole>(role)));
+		if (!widget)
+			continue;
+
+		VtableClone& clone = g_vtableClones[role];
+		if (widget->m_Data.vtable == AddressPointOf(clone))
+		{
+			clone.widget = widget;
+			clone.generation = g_watcher.widgetGeneration;
+			continue;
+		}
+
+		SwapWidgetVtable(clone, widget, static_cast<WidgetRole>(role));
+	}
+}
+
+void RestoreSwappedWidgets()
+{
+	// clone.widget is only trusted while the plugin and page it was found in haven't been reloaded,
+	// past that it may already be freed and the widget is looked up again by name
+	uint32_t generation = g_watcher.widgetGeneration;
+	for (int role = ROLE_NONE + 1; role < ROLE_COUNT; role++)
+	{
+		VtableClone& clone = g_vtableClones[role];
+		if (!clone.original)
+			continue;
+
+		paf::PhWidget* widget = clone.widget && clone.generation == generation
+			? clone.widget
+			: FindTargetWidget(WidgetRoles::NameOf(static_cast<WidgetRole>(role)));
+
+		if (widget && widget->m_Data.vtable == AddressPointOf(clone))
+			widget->m_Data.vtable = clone.original;
+
+		clone.widget = nullptr;
+	}
+}
+
+// ===== QUIESCENCE =====
+// While a game runs the IP text is hidden and the logos are off screen, so every View lookup, IP text
+// rebuild and lv1 peek is wasted PPU time taken from the game. The watcher thread parks on an event flag,
+// the hooks take a single-branch exit and the bound controller sleeps until the XMB is back.
+// Entering is held off until the gameboot text has had time to play out.
+constexpr uint64_t QUIESCENCE_DELAY_US = GB_ANIMATION_TOTAL_DURATION_US + 1000000;
+constexpr uint64_t XMB_ACTIVE_BIT = 1;
+
+sys_event_flag_t g_xmbActiveFlag = SYS_EVENT_FLAG_ID_INVALID;
+
+void CreateQuiescenceFlag()
+{
+	sys_event_flag_attribute_t attr;
+	sys_event_flag_attribute_initialize(attr);
+	attr.type = SYS_SYNC_WAITER_MULTIPLE;
+	sys_event_flag_attribute_name_set(attr.name, "swXmbOn");
+
+	if (sys_event_flag_create(&g_xmbActiveFlag, &attr, XMB_ACTIVE_BIT) != CELL_OK)
+		g_xmbActiveFlag = SYS_EVENT_FLAG_ID_INVALID;
+}
+
+void DestroyQuiescenceFlag()
+{
+	if (g_xmbActiveFlag == SYS_EVENT_FLAG_ID_INVALID)
+		return;
+
+	sys_event_flag_t flag = g_xmbActiveFlag;
+	g_xmbActiveFlag = SYS_EVENT_FLAG_ID_INVALID;
+	sys_event_flag_destroy(flag);
+}
+
+void EnterQuiescence()
+{
+	g_watcher.quiescent = true;
+	if (g_xmbActiveFlag != SYS_EVENT_FLAG_ID_INVALID && !g_watcher.stopping)
+		sys_event_flag_clear(g_xmbActiveFlag, ~XMB_ACTIVE_BIT);
+}
+
+void LeaveQuiescence()
+{
+	g_watcher.resumeSerial++;
+	__lwsync(); // the hook must see the new serial no later than the cleared flag
+	g_watcher.quiescent = false;
+	if (g_xmbActiveFlag != SYS_EVENT_FLAG_ID_INVALID)
+		sys_event_flag_set(g_xmbActiveFlag, XMB_ACTIVE_BIT);
+}
+
+// Shutdown: wakes every thread parked in WaitForXmb() whatever the mode and whatever the watcher did last,
+// and keeps them from parking again. Their loops check g_watcher.stopping and exit.
+void ReleaseWaiters()
+{
+	g_watcher.stopping = true;
+	__lwsync();
+	if (g_xmbActiveFlag != SYS_EVENT_FLAG_ID_INVALID)
+		sys_event_flag_set(g_xmbActiveFlag, XMB_ACTIVE_BIT);
+}
+
+// leaving a game wakes everything right away instead of on the watcher's next poll
+void OnQuiescenceModeChanged(const CooperationModeSnapshot& snapshot)
+{
+	if (snapshot.mode != vshmain::CooperationMode::Game && g_watcher.quiescent)
+		LeaveQuiescence();
+}
+
+// Polled by the watcher thread. Returns whether we're quiescent.
+bool UpdateQuiescence()
+{
+	PublishCooperationMode(vshmain::GetCooperationMode());
+
+	CooperationModeSnapshot mode = GetCooperationModeSnapshot();
+	if (mode.mode != vshmain::CooperationMode::Game)
+	{
+		if (g_watcher.quiescent)
+			LeaveQuiescence();
+		return false;
+	}
+
+	if (!g_watcher.quiescent && sys_time_get_system_time() - mode.changedAt_us >= QUIESCENCE_DELAY_US)
+		EnterQuiescence();
+
+	return g_watcher.quiescent;
+}
+
+// Blocks while quiescent. A zero timeout waits until LeaveQuiescence() or ReleaseWaiters() wakes us.
+void WaitForXmb(uint64_t timeout_us)
+{
+	if (!g_watcher.quiescent || g_watcher.stopping)
+		return;
+
+	if (g_xmbActiveFlag == SYS_EVENT_FLAG_ID_INVALID)
+	{
+		Timer::Sleep(timeout_us ? timeout_us / 1000 : 500);
+		return;
+	}
+
+	uint64_t result;
+	sys_event_flag_wait(g_xmbActiveFlag, XMB_ACTIVE_BIT, SYS_EVENT_FLAG_WAIT_AND, &result, timeout_us);
+}
+
+// ===== BOUND CONTROLLER =====
+// Hookless mode for the alphas: the watcher thread resolves the target handles along with its other lookups,
+// and a background thread pushes the precomputed alphas to them at a fixed cadence. That thread makes no paf
+// calls at all, it reads metaAlpha off the parent and stores metaAlpha and colorScaleRGBA.a on the targets.
+// Text has to go through paf's SetText(), which belongs on the render thread, so the two IP text widgets
+// keep a swapped vtable and apply the published snapshot from their own draw call.
+// Every push first checks that the widget generation hasn't moved since the handles were resolved, the
+// watcher thread drops handles that paf no longer has attached, and both re-resolve on the next pass.
+constexpr uint64_t BOUND_CONTROLLER_INTERVAL_MS = 16;
+constexpr uint32_t IP_TEXT_ROLES = WidgetRoles::RoleBit(ROLE_IP_TEXT) | WidgetRoles::RoleBit(ROLE_IP_TEXT_HEADER);
+
+struct BoundWidget
+{
+	paf::PhWidget* widget;
+	paf::PhWidget* parent;
+};
+
+BoundWidget g_boundWidgets[ROLE_COUNT]{};
+paf::PhWidget* g_boundIndicator = nullptr; // what GetParent() returned on the watcher thread
+volatile uint32_t g_boundGeneration = 0;
+Thread g_boundControllerThread;
+volatile bool g_boundControllerRunning = false;
+
+bool IsIpTextRole(int role)
+{
+	return role == ROLE_IP_TEXT || role == ROLE_IP_TEXT_HEADER;
+}
+
+// watcher thread
+void ResolveBoundWidgets()
+{
+	if (g_boundGeneration != g_watcher.widgetGeneration)
+	{
+		for (int role = 0; role < ROLE_COUNT; role++)
+			g_boundWidgets[role].widget = nullptr;
+		__lwsync();
+		g_boundGeneration = g_watcher.widgetGeneration;
+	}
+
+	g_boundIndicator = GetParent();
+
+	uint32_t roles = WidgetRoles::HandledRoles(g_is_hen);
+	for (int role = ROLE_NONE + 1; role < ROLE_COUNT; role++)
+	{
+		BoundWidget& bound = g_boundWidgets[role];
+		if (!(roles & WidgetRoles::RoleBit(static_cast<WidgetRole>(role))))
+			continue;
+
+		// a widget that got reparented or that paf let go of is resolved again
+		paf::PhWidget* widget = bound.widget;
+		if (widget && widget->m_Data.parent == bound.parent && widget->IsAttached())
+			continue;
+
+		widget = FindTargetWidget(WidgetRoles::NameOf(static_cast<WidgetRole>(role)));
+		bound.widget = nullptr;
+		__lwsync();
+		bound.parent = widget ? widget->m_Data.parent : nullptr;
+		__lwsync();
+		bound.widget = widget;
+	}
+}
+
+// bound controller thread, a handle is only dereferenced while the generation it was resolved in is current
+bool IsBoundGenerationCurrent()
+{
+	return g_boundGeneration == g_watcher.widgetGeneration;
+}
+
+// the alpha part of each handler only, the text roles get their text from BoundTextDrawThis_Hook()
+void PushBoundWidgets(const FrameState& frame)
+{
+	for (int role = ROLE_NONE + 1; role < ROLE_COUNT; role++)
+	{
+		BoundWidget& bound = g_boundWidgets[role];
+		paf::PhWidget* widget = bound.widget;
+		if (!widget)
+			continue;
+
+		if (!IsBoundGenerationCurrent() || widget->m_Data.parent != bound.parent)
+		{
+			bound.widget = nullptr;
+			continue;
+		}
+
+		if (role == ROLE_ENHANCED_GAME_TEXT)
+			HandleGamebootText(widget, static_cast<WidgetRole>(role), frame);
+		else if (!IsIpTextRole(role))
+			HandleClockLogo(widget, static_cast<WidgetRole>(role), frame);
+		else if (g_isIpTextDisabled)
+			ApplyIpTextVisibility<true>(widget, frame);
+		else
+			ApplyIpTextVisibility<false>(widget, frame);
+	}
+}
+
+template<bool IsHen>
+void RunBoundFrame(uint64_t timebase)
+{
+	paf::PhWidget* indicator = IsBoundGenerationCurrent() ? g_boundIndicator : nullptr;
+	BeginFrame<IsHen>(timebase, indicator);
+	PushBoundWidgets(*g_frameState.Get());
+}
+
+void BoundControllerThread()
+{
+	while (g_boundControllerRunning && !g_watcher.stopping)
+	{
+		if (g_watcher.quiescent)
+		{
+			WaitForXmb(0);
+			continue;
+		}
+
+		// the cadence is longer than a frame epoch, every push starts a new one
+		uint64_t timebase;
+		SYS_TIMEBASE_GET(timebase);
+		if (g_is_hen)
+			RunBoundFrame<true>(timebase);
+		else
+			RunBoundFrame<false>(timebase);
+
+		Timer::Sleep(BOUND_CONTROLLER_INTERVAL_MS);
+	}
+}
+
+// render thread, installed on the IP text widgets only. The text's visibility is the controller's to push.
+int BoundTextDrawThis_Hook(paf::PhWidget* _this, unsigned int r4, bool r5)
+{
+	VtableClone* clone = CloneOf(_this->m_Data.vtable);
+	if (!g_watcher.quiescent && !g_isIpTextDisabled)
+		ApplyIpTextSnapshot(_this, clone->role);
+
+	return clone->original->CallMethod<int>(PHWIDGET_DRAWTHIS_SLOT, _this, r4, r5);
+}
+
+void StartBoundController()
+{
+	g_boundControllerRunning = true;
+	g_boundControllerThread = Thread(BoundControllerThread, &g_boundControllerThread, "bound_controller()");
+}
+
+void StopBoundController()
+{
+	if (!g_boundControllerRunning)
+		return;
+
+	g_boundControllerRunning = false;
+	g_boundControllerThread.Join();
+}
+
+HookMode GetConfiguredHookMode()
+{
+	const char* modeFilePath = "/dev_hdd0/tmp/system_watcher_hook_mode.txt";
+	int fd;
+
+	if (cellFsOpen(modeFilePath, CELL_FS_O_RDONLY, &fd, nullptr, 0) != CELL_FS_SUCCEEDED)
+	{
+		return HookMode::GlobalDetour;
+	}
+
+	char modeValue = '0';
+	cellFsRead(fd, &modeValue, 1, nullptr);
+	cellFsClose(fd);
+
+	switch (modeValue)
+	{
+	case '1': return HookMode::VtableSwap;
+	case '2': return HookMode::BoundController;
+	default: return HookMode::GlobalDetour;
+	}
+}
+
+// ===== HOOK VARIANTS =====
+struct HookVariant
+{
+	DrawThisHook detour;
+	DrawThisHook swapped;
+};
+
+// indexed by (IsHen << 1) | IpTextDisabled
+const HookVariant g_hookVariants[4] =
+{
+	{ pafWidgetDrawThis_Hook<false, false>, SwappedDrawThis_Hook<false, false> },
+	{ pafWidgetDrawThis_Hook<false, true>, SwappedDrawThis_Hook<false, true> },
+	{ pafWidgetDrawThis_Hook<true, false>, SwappedDrawThis_Hook<true, false> },
+	{ pafWidgetDrawThis_Hook<true, true>, SwappedDrawThis_Hook<true, true> },
+};
+
+const HookVariant& SelectHookVariant()
+{
+	return g_hookVariants[(g_is_hen ? 2 : 0) | (g_isIpTextDisabled ? 1 : 0)];
+}
+
+// ===== INSTALL / REMOVE =====
+void Install()
+{
+	g_is_hen = IsPayloadHen();
+	g_isIpTextDisabled = !IsIpTextEnabled();
+	LoadIpText();
+	InitFrameClock();
+	g_ipTextPublisher.Reserve();
+	LoadServerTable();
+	StartNetworkWatcher();
+	if (!g_isIpTextDisabled)
+		StartNetworkProbe();
+
+	g_hookMode = GetConfiguredHookMode();
+	g_hookStats.mode = g_hookMode;
+
+	const HookVariant& variant = SelectHookVariant();
+	g_swappedDrawThis_Hook = g_hookMode == HookMode::BoundController ? BoundTextDrawThis_Hook : variant.swapped;
+
+	CreateQuiescenceFlag();
+	InstallCooperationModeHooks();
+	SubscribeCooperationMode(OnQuiescenceModeChanged);
+	if (!g_is_hen)
+	{
+		StartClockPrefetch();
+		SubscribeCooperationMode(OnClockModeChanged);
+	}
+
+	if (g_hookMode == HookMode::GlobalDetour)
+		pafWidgetDrawThis_Detour = new Detour(((opd_s*)paf::paf_63D446B8)->sub, variant.detour);
+	else if (g_hookMode == HookMode::BoundController)
+		StartBoundController();
+}
+
+void UpdateWidgetHooks()
+{
+	if (g_hookMode == HookMode::VtableSwap)
+		BindSwappedWidgets(WidgetRoles::HandledRoles(g_is_hen));
+	else if (g_hookMode == HookMode::BoundController)
+	{
+		ResolveBoundWidgets();
+		if (!g_isIpTextDisabled)
+			BindSwappedWidgets(IP_TEXT_ROLES);
+	}
+}
+
+void Remove()
+{
+	if (pafWidgetDrawThis_Detour)
+		delete pafWidgetDrawThis_Detour;
+
+	RemoveCooperationModeHooks();
+	StopNetworkWatcher();
+
+	if (g_hookMode == HookMode::VtableSwap || g_hookMode == HookMode::BoundController)
+		RestoreSwappedWidgets();
+
+	// EnterQuiescence() may have cleared the flag right after any check we could make here, so the waiters
+	// are released unconditionally
+	ReleaseWaiters();
+
+	StopBoundController();
+	StopNetworkProbe();
+	StopClockPrefetch();
+	DestroyQuiescenceFlag();
 }
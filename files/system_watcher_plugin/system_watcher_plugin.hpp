@@ -2,17 +2,61 @@
 #pragma once
 
 #include <vshlib.hpp>
+#include "Utils/ClockSampler.hpp"
+#include "render_state.hpp"
 //extern bool gIsDebugXmbPlugin;
 extern wchar_t gIpBuffer[512];
-extern paf::View* xmb_plugin;
-extern paf::View* system_plugin;
-extern paf::PhWidget* page_xmb_indicator;
-extern paf::PhWidget* page_notification;
+
+// Everything the watcher thread writes and the draw hook reads, kept on its own cache line so the
+// watcher's stores never invalidate the line holding the render thread's state (and vice versa).
+struct PPU_CACHE_LINE_ALIGNED WatcherState
+{
+	paf::View* xmb_plugin;
+	paf::View* system_plugin;
+	paf::PhWidget* page_xmb_indicator;
+	paf::PhWidget* page_notification;
+	volatile uint32_t widgetGeneration; // bumped whenever the handles above change, consumed by the draw hook
+	volatile bool quiescent;            // a game is running, nothing of ours has any work to do
+	volatile uint32_t resumeSerial;     // bumped on every return to the XMB so the hook refreshes its state once
+	volatile bool stopping;             // shutting down: nothing parks anymore and the background loops exit
+};
+
+extern WatcherState g_watcher;
+
+enum class HookMode
+{
+	GlobalDetour,   // inline detour on PhWidget::DrawThis, sees every widget
+	VtableSwap,     // cloned vtables on the target widgets only
+	BoundController // a background thread pushes alphas to resolved widget handles, only the IP text keeps a swapped vtable
+};
+
+struct HookStats
+{
+	HookMode mode;
+	uint64_t frames;
+	uint32_t lastFrameCalls;       // draw calls that entered our code during the last frame
+	uint32_t lastFrameTargetCalls; // how many of those were widgets we act on
+	uint64_t lastFrameTicks;       // timebase ticks spent in our code during the last frame
+	uint64_t maxFrameTicks;
+	uint64_t totalTicks;
+	uint32_t setTextCalls;         // ip_text/ip_text_header SetText() calls actually issued
+	uint64_t setTextSkipped;       // draws that found the widget already showing the current text
+	uint32_t gamebootCalls;        // enhanced_game_text draws handled
+	uint64_t gamebootTicks;        // timebase ticks spent on them
+	uint64_t gamebootMaxTicks;
+};
 
 bool LoadIpText();
 bool CanCreateIpText();
 paf::PhWidget* GetParent();
 std::wstring GetText();
 void CreateIpText(); 
+void PublishIpText();
+void InvalidateWidgetCache();
 void Install();
-void Remove();
\ No newline at end of file
+void UpdateWidgetHooks();
+bool UpdateQuiescence();
+void WaitForXmb(uint64_t timeout_us);
+void ReleaseWaiters();
+void Remove();
+void WriteHookStats();
\ No newline at end of file
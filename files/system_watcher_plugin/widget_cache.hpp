@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "widget_roles.hpp"
+
+// Maps a widget pointer to the role resolved for it the first time it was drawn, so a steady-state
+// draw call costs one pointer hash instead of a name classification.
+// Only the render thread touches the table; other threads invalidate it by bumping a generation
+// number that the owner picks up through Sync().
+class WidgetRoleCache
+{
+public:
+	static constexpr uint32_t CapacityBits = 9;
+	static constexpr uint32_t Capacity = 1u << CapacityBits;
+	static constexpr uint32_t MaxLoad = Capacity * 3 / 4;
+
+	WidgetRoleCache() = default;
+
+	// Drops every entry when the requested generation differs from the one the table was filled with.
+	void Sync(uint32_t generation)
+	{
+		if (generation != m_Generation)
+			Reset(generation);
+	}
+
+	// The name's length and its first and last characters guard against a freed widget's address being
+	// reused by a differently named one; they're read from the name the caller already has at hand.
+	bool Lookup(const void* widget, const char* name, size_t nameLength, WidgetRole& role) const
+	{
+		uint32_t index = Hash(widget);
+		for (uint32_t probe = 0; probe < Capacity; probe++)
+		{
+			const Slot& slot = m_Slots[index];
+			if (slot.stamp != m_Stamp)
+				return false;
+
+			if (slot.key == widget)
+			{
+				if (slot.nameLength != nameLength || slot.nameFirst != NameFirst(name, nameLength) || slot.nameLast != NameLast(name, nameLength))
+					return false;
+
+				role = static_cast<WidgetRole>(slot.role);
+				return true;
+			}
+
+			index = (index + 1) & (Capacity - 1);
+		}
+
+		return false;
+	}
+
+	void Insert(const void* widget, const char* name, size_t nameLength, WidgetRole role)
+	{
+		if (m_Count >= MaxLoad)
+			Flush();
+
+		uint32_t index = Hash(widget);
+		for (;;)
+		{
+			Slot& slot = m_Slots[index];
+			if (slot.stamp != m_Stamp)
+			{
+				m_Count++;
+				break;
+			}
+
+			if (slot.key == widget)
+				break;
+
+			index = (index + 1) & (Capacity - 1);
+		}
+
+		Slot& slot = m_Slots[index];
+		slot.key = widget;
+		slot.stamp = m_Stamp;
+		slot.nameLength = static_cast<uint16_t>(nameLength);
+		slot.nameFirst = NameFirst(name, nameLength);
+		slot.nameLast = NameLast(name, nameLength);
+		slot.role = static_cast<uint8_t>(role);
+	}
+
+	uint32_t GetCount() const { return m_Count; }
+	uint32_t GetGeneration() const { return m_Generation; }
+
+private:
+	struct Slot
+	{
+		const void* key;
+		uint32_t stamp;
+		uint16_t nameLength;
+		char nameFirst;
+		char nameLast;
+		uint8_t role;
+	};
+
+	static char NameFirst(const char* name, size_t length) { return length ? name[0] : 0; }
+	static char NameLast(const char* name, size_t length) { return length ? name[length - 1] : 0; }
+
+	static uint32_t Hash(const void* widget)
+	{
+		// widgets are heap objects, the low bits carry no information
+		uint32_t value = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(widget) >> 4);
+		return (value * 2654435761u) >> (32 - CapacityBits);
+	}
+
+	void Reset(uint32_t generation)
+	{
+		m_Generation = generation;
+		Flush();
+	}
+
+	// slots stamped with an older value count as empty, so flushing doesn't touch the table
+	void Flush()
+	{
+		m_Count = 0;
+		if (++m_Stamp == 0)
+		{
+			for (uint32_t i = 0; i < Capacity; i++)
+				m_Slots[i].stamp = 0;
+			m_Stamp = 1;
+		}
+	}
+
+private:
+	Slot m_Slots[Capacity]{};
+	uint32_t m_Stamp = 1;
+	uint32_t m_Generation = 0;
+	uint32_t m_Count = 0;
+};
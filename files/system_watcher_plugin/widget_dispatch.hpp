@@ -0,0 +1,25 @@
+#pragma once
+
+#include "widget_roles.hpp"
+
+// Which handler a classified widget goes to. The flags never change after Install(), so they're template
+// parameters: each deployed configuration gets its own instantiation, tests neither flag per draw call,
+// and the HEN variants carry no clock or gameboot code at all.
+// `Handlers` supplies the bodies, the plugin's act on paf widgets and the host benchmark's only count.
+template<bool IsHen, bool IpTextDisabled, typename Handlers, typename Widget, typename Frame>
+inline void DispatchWidget(Widget* widget, WidgetRole role, const Frame& frame)
+{
+	if (role == ROLE_IP_TEXT || role == ROLE_IP_TEXT_HEADER)
+	{
+		Handlers::template IpText<IpTextDisabled>(widget, role, frame);
+		return;
+	}
+
+	if (IsHen)
+		return;
+
+	if (role == ROLE_ENHANCED_GAME_TEXT)
+		Handlers::GamebootText(widget, role, frame);
+	else
+		Handlers::ClockLogo(widget, role, frame);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cstring>
+
+// Widgets the draw hook acts on. Everything else is ROLE_NONE and goes straight to the original draw.
+enum WidgetRole
+{
+	ROLE_NONE,
+	ROLE_IP_TEXT,
+	ROLE_IP_TEXT_HEADER,
+	ROLE_ENHANCED_GAME_TEXT,
+	ROLE_PSLOGO,
+	ROLE_PSLOGO_RING,
+	ROLE_PERFORMANCE_MODE_TEXT,
+	ROLE_PERFORMANCE_MODE_TEXT_GLOW,
+	ROLE_BALANCED_MODE_TEXT,
+	ROLE_BALANCED_MODE_TEXT_GLOW,
+	ROLE_POWER_SAVING_MODE_TEXT,
+	ROLE_POWER_SAVING_MODE_TEXT_GLOW,
+	ROLE_COUNT
+};
+
+namespace WidgetRoles
+{
+	struct Entry
+	{
+		const char* name;
+		size_t length;
+		WidgetRole role;
+		bool needsClock; // driven by the lv1 clock state, which HEN can't peek
+	};
+
+	template<size_t N>
+	constexpr Entry MakeEntry(const char(&name)[N], WidgetRole role, bool needsClock = false) {
+		return Entry{ name, N - 1, role, needsClock };
+	}
+
+	// entry 0 is the "not interesting" sentinel, its zero length never matches a real name
+	constexpr Entry kEntries[] =
+	{
+		MakeEntry("", ROLE_NONE),
+		MakeEntry("ip_text", ROLE_IP_TEXT),
+		MakeEntry("ip_text_header", ROLE_IP_TEXT_HEADER),
+		MakeEntry("enhanced_game_text", ROLE_ENHANCED_GAME_TEXT, true),
+		MakeEntry("pslogo", ROLE_PSLOGO, true),
+		MakeEntry("pslogo_ring", ROLE_PSLOGO_RING, true),
+		MakeEntry("performance_mode_text", ROLE_PERFORMANCE_MODE_TEXT, true),
+		MakeEntry("performance_mode_text_glow", ROLE_PERFORMANCE_MODE_TEXT_GLOW, true),
+		MakeEntry("balanced_mode_text", ROLE_BALANCED_MODE_TEXT, true),
+		MakeEntry("balanced_mode_text_glow", ROLE_BALANCED_MODE_TEXT_GLOW, true),
+		MakeEntry("power_saving_mode_text", ROLE_POWER_SAVING_MODE_TEXT, true),
+		MakeEntry("power_saving_mode_text_glow", ROLE_POWER_SAVING_MODE_TEXT_GLOW, true),
+	};
+
+	constexpr size_t kEntryCount = sizeof(kEntries) / sizeof(kEntries[0]);
+	constexpr size_t kTableSize = 32; // power of two
+
+	// O(1) regardless of the name length: only the length and the first/last characters are mixed in
+	constexpr uint32_t Hash(const char* name, size_t length) {
+		return static_cast<uint32_t>(length * 3 + static_cast<uint8_t>(name[0]) + (static_cast<uint8_t>(name[length - 1]) << 2)) & (kTableSize - 1);
+	}
+
+	constexpr uint32_t HashOf(size_t index) {
+		return Hash(kEntries[index].name, kEntries[index].length);
+	}
+
+	// C++11 constexpr, so everything below is written as single-return recursion
+	constexpr bool CollidesWithAny(size_t index, size_t other) {
+		return other >= kEntryCount ? false : (HashOf(index) == HashOf(other) || CollidesWithAny(index, other + 1));
+	}
+
+	constexpr bool IsPerfect(size_t index) {
+		return index >= kEntryCount ? true : (!CollidesWithAny(index, index + 1) && IsPerfect(index + 1));
+	}
+
+	static_assert(kEntryCount < 256, "slot table stores entry indices as uint8_t");
+	static_assert(IsPerfect(1), "widget name hash has a collision, tweak WidgetRoles::Hash or grow kTableSize");
+
+	constexpr uint8_t EntryForSlot(uint32_t slot, size_t index) {
+		return index >= kEntryCount ? 0 : (HashOf(index) == slot ? static_cast<uint8_t>(index) : EntryForSlot(slot, index + 1));
+	}
+
+#define WIDGET_ROLE_SLOTS_4(n) EntryForSlot(n, 1), EntryForSlot(n + 1, 1), EntryForSlot(n + 2, 1), EntryForSlot(n + 3, 1)
+#define WIDGET_ROLE_SLOTS_16(n) WIDGET_ROLE_SLOTS_4(n), WIDGET_ROLE_SLOTS_4(n + 4), WIDGET_ROLE_SLOTS_4(n + 8), WIDGET_ROLE_SLOTS_4(n + 12)
+
+	constexpr uint8_t kSlots[kTableSize] = { WIDGET_ROLE_SLOTS_16(0), WIDGET_ROLE_SLOTS_16(16) };
+
+#undef WIDGET_ROLE_SLOTS_16
+#undef WIDGET_ROLE_SLOTS_4
+
+	constexpr const char* NameOf(WidgetRole role, size_t index = 1) {
+		return index >= kEntryCount ? nullptr : (kEntries[index].role == role ? kEntries[index].name : NameOf(role, index + 1));
+	}
+
+	constexpr uint32_t RoleBit(WidgetRole role) {
+		return 1u << role;
+	}
+
+	// bit per role the hook acts on in a given configuration
+	constexpr uint32_t HandledRoles(bool isHen, size_t index = 1) {
+		return index >= kEntryCount ? 0 : ((isHen && kEntries[index].needsClock ? 0 : RoleBit(kEntries[index].role)) | HandledRoles(isHen, index + 1));
+	}
+
+	static_assert(ROLE_COUNT <= 32, "role masks are 32 bits wide");
+
+	// one hash and one length check for widgets we don't care about, one memcmp for the ones we do
+	inline WidgetRole Classify(const char* name, size_t length)
+	{
+		if (length == 0)
+			return ROLE_NONE;
+
+		const Entry& entry = kEntries[kSlots[Hash(name, length)]];
+		if (entry.length != length || memcmp(entry.name, name, length) != 0)
+			return ROLE_NONE;
+
+		return entry.role;
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+// Timing helpers for the host benchmarks. Run with --quick (as ctest does) for a smoke run that only
+// checks the results; timings from such a run mean nothing.
+namespace bench
+{
+	inline bool IsQuick(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; i++)
+			if (std::strcmp(argv[i], "--quick") == 0)
+				return true;
+		return false;
+	}
+
+	// keeps the optimiser from dropping a result nobody reads
+	template<typename T>
+	inline void Consume(const T& value)
+	{
+		static volatile T sink;
+		sink = value;
+		(void)sink;
+	}
+
+	// best of `repeats` runs of fn(), in nanoseconds per `operations`
+	template<typename Fn>
+	inline double Measure(uint64_t operations, int repeats, Fn fn)
+	{
+		double best = 0;
+		for (int i = 0; i < repeats; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			if (i == 0 || elapsed < best)
+				best = elapsed;
+		}
+		return operations ? best / operations : best;
+	}
+
+	inline void Report(const char* name, double nsPerOp)
+	{
+		std::printf("  %-40s %10.2f ns/op\n", name, nsPerOp);
+	}
+}
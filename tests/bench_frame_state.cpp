@@ -0,0 +1,164 @@
+// Per-frame cost of the draw hook's logo work against the number of widgets drawn: recomputed for every
+// logo widget, as the hook did before the frame state, and computed once per frame epoch by
+// ComputeLogoAlphas with every widget indexing into the result.
+// Both paths read the same simulated clock; the old path's sys_time_get_current_time per draw call isn't
+// part of the timing, so the gap on the console is wider than here.
+
+#include <vector>
+#include <random>
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "logo_alphas.hpp"
+
+namespace
+{
+	constexpr uint64_t FRAME_US = 16667;
+	constexpr uint64_t EPOCH_US = 8000;
+
+	constexpr Keyframe PULSE_KEYS[] =
+	{
+		{ 0, 0.f, nullptr },
+		{ 800000, 1.f, Ease::Linear },
+		{ 825000, 1.f, nullptr },
+		{ 1625000, 0.f, Ease::Linear },
+		{ 2225000, 0.f, nullptr },
+	};
+	constexpr Timeline PULSE(PULSE_KEYS, true);
+
+	struct Parent
+	{
+		float metaAlpha;
+	};
+
+	// one frame's draw list: every logo widget once, somewhere among `count` others
+	std::vector<WidgetRole> MakeDrawList(size_t count)
+	{
+		std::vector<WidgetRole> roles(count, ROLE_NONE);
+		std::mt19937 random(99);
+		for (int role = ROLE_PSLOGO; role <= ROLE_POWER_SAVING_MODE_TEXT_GLOW; role++)
+			roles[random() % count] = static_cast<WidgetRole>(role);
+		return roles;
+	}
+
+	bool IsLogo(WidgetRole role)
+	{
+		return role >= ROLE_PSLOGO && role <= ROLE_POWER_SAVING_MODE_TEXT_GLOW;
+	}
+
+	struct RefreshIntervals
+	{
+		uint64_t lastIp_us = 0;
+		uint64_t lastClock_us = 0;
+		uint32_t refreshes = 0;
+	};
+
+	// every draw call checks both refresh intervals, every logo widget looks at the parent, switches on
+	// the clock state and steps the pulse itself
+	float DrawPerWidget(const std::vector<WidgetRole>& roles, uint64_t time_us, const Parent* parent, ClockState clockState, LogoPulse& pulse,
+		RefreshIntervals& intervals)
+	{
+		float sum = 0.f;
+		for (WidgetRole role : roles)
+		{
+			if (time_us - intervals.lastIp_us >= 1000000)
+			{
+				intervals.lastIp_us = time_us;
+				intervals.refreshes++;
+			}
+			if (time_us - intervals.lastClock_us >= 100000)
+			{
+				intervals.lastClock_us = time_us;
+				intervals.refreshes++;
+			}
+
+			if (!IsLogo(role))
+				continue;
+
+			float alpha[LOGO_TARGET_COUNT];
+			bool parentVisible = parent && parent->metaAlpha > 0.1f;
+			ComputeLogoAlphas(alpha, clockState, parentVisible, time_us, PULSE, pulse);
+			sum += alpha[role - ROLE_PSLOGO];
+		}
+		return sum;
+	}
+
+	struct Frame
+	{
+		uint64_t time_us = ~0ull;
+		float logoAlpha[LOGO_TARGET_COUNT];
+	};
+
+	// the first draw call of an epoch builds the frame, the rest only compare the clock and index
+	float DrawPerFrame(const std::vector<WidgetRole>& roles, uint64_t time_us, const Parent* parent, ClockState clockState, LogoPulse& pulse, Frame& frame)
+	{
+		float sum = 0.f;
+		for (WidgetRole role : roles)
+		{
+			if (time_us - frame.time_us >= EPOCH_US)
+			{
+				frame.time_us = time_us;
+				ComputeLogoAlphas(frame.logoAlpha, clockState, parent && parent->metaAlpha > 0.1f, time_us, PULSE, pulse);
+			}
+
+			if (IsLogo(role))
+				sum += frame.logoAlpha[role - ROLE_PSLOGO];
+		}
+		return sum;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	const int frames = quick ? 600 : 20000;
+	const size_t counts[] = { 50, 100, 200, 400, 800, 1600 };
+
+	Parent parent{ 1.f };
+
+	// both paths have to draw the same alphas, through a pulse start, a hidden parent and a state change
+	{
+		std::vector<WidgetRole> roles = MakeDrawList(200);
+		LogoPulse widgetPulse, framePulse;
+		RefreshIntervals intervals;
+		Frame frame;
+		for (int i = 0; i < frames; i++)
+		{
+			uint64_t time_us = 1000000 + i * FRAME_US;
+			Parent shown{ (i / 100) % 3 == 2 ? 0.f : 1.f };
+			ClockState clockState = (i / 250) % 2 ? CLOCK_BALANCED : CLOCK_OVERCLOCK;
+			CHECK_NEAR(DrawPerWidget(roles, time_us, &shown, clockState, widgetPulse, intervals),
+				DrawPerFrame(roles, time_us, &shown, clockState, framePulse, frame), 1e-5f);
+		}
+	}
+
+	if (quick)
+		return check::Result();
+
+	std::printf("logo alphas per frame, %d frames, eight logo widgets per frame\n", frames);
+	for (size_t count : counts)
+	{
+		std::vector<WidgetRole> roles = MakeDrawList(count);
+		std::printf("%zu widgets drawn\n", count);
+
+		bench::Report("per logo widget", bench::Measure(frames, 5, [&] {
+			LogoPulse pulse;
+			RefreshIntervals intervals;
+			float sum = 0.f;
+			for (int i = 0; i < frames; i++)
+				sum += DrawPerWidget(roles, 1000000 + i * FRAME_US, &parent, CLOCK_OVERCLOCK, pulse, intervals);
+			bench::Consume(sum + intervals.refreshes);
+		}));
+
+		bench::Report("per frame epoch (ComputeLogoAlphas)", bench::Measure(frames, 5, [&] {
+			LogoPulse pulse;
+			Frame frame;
+			float sum = 0.f;
+			for (int i = 0; i < frames; i++)
+				sum += DrawPerFrame(roles, 1000000 + i * FRAME_US, &parent, CLOCK_OVERCLOCK, pulse, frame);
+			bench::Consume(sum);
+		}));
+	}
+
+	return check::Result();
+}
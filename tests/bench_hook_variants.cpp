@@ -0,0 +1,211 @@
+// Size and per-call cost of the four DispatchWidget instantiations Install() picks from, against one
+// dispatcher that tests the install-time flags on every call, as the hook did before it was specialised.
+// Each entry point lives in its own section so the linker's __start_/__stop_ symbols give its size. These
+// are host instructions with stand-in handlers: the sizes compare the variants with each other, they
+// aren't the PPU sizes of the plugin's hooks.
+
+#include <vector>
+#include <random>
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "widget_dispatch.hpp"
+
+namespace
+{
+	struct Widget
+	{
+		float metaAlpha;
+		float alpha;
+	};
+
+	struct Frame
+	{
+		float gamebootAlpha;
+		float logoAlpha[ROLE_COUNT];
+	};
+
+	// the plugin's handlers with the paf calls left out: the same stores, nothing else
+	struct StoreHandlers
+	{
+		template<bool IpTextDisabled>
+		static void IpText(Widget* widget, WidgetRole, const Frame&) { widget->metaAlpha = IpTextDisabled ? 0.f : 1.f; }
+		static void GamebootText(Widget* widget, WidgetRole, const Frame& frame) { widget->metaAlpha = widget->alpha = frame.gamebootAlpha; }
+		static void ClockLogo(Widget* widget, WidgetRole role, const Frame& frame) { widget->alpha = frame.logoAlpha[role]; }
+	};
+
+	volatile bool g_isHen = false;
+	volatile bool g_isIpTextDisabled = false;
+}
+
+#define HOOK_VARIANT(name) extern "C" __attribute__((section(#name), noinline, used))
+
+HOOK_VARIANT(hook_clock_ip) void DispatchClockIp(Widget* widget, WidgetRole role, const Frame& frame)
+{
+	DispatchWidget<false, false, StoreHandlers>(widget, role, frame);
+}
+
+HOOK_VARIANT(hook_clock_noip) void DispatchClockNoIp(Widget* widget, WidgetRole role, const Frame& frame)
+{
+	DispatchWidget<false, true, StoreHandlers>(widget, role, frame);
+}
+
+HOOK_VARIANT(hook_hen_ip) void DispatchHenIp(Widget* widget, WidgetRole role, const Frame& frame)
+{
+	DispatchWidget<true, false, StoreHandlers>(widget, role, frame);
+}
+
+HOOK_VARIANT(hook_hen_noip) void DispatchHenNoIp(Widget* widget, WidgetRole role, const Frame& frame)
+{
+	DispatchWidget<true, true, StoreHandlers>(widget, role, frame);
+}
+
+// the flags read on every call, every handler compiled in
+HOOK_VARIANT(hook_runtime_flags) void DispatchRuntimeFlags(Widget* widget, WidgetRole role, const Frame& frame)
+{
+	if (role == ROLE_IP_TEXT || role == ROLE_IP_TEXT_HEADER)
+	{
+		if (g_isIpTextDisabled)
+			StoreHandlers::IpText<true>(widget, role, frame);
+		else
+			StoreHandlers::IpText<false>(widget, role, frame);
+		return;
+	}
+
+	if (g_isHen)
+		return;
+
+	if (role == ROLE_ENHANCED_GAME_TEXT)
+		StoreHandlers::GamebootText(widget, role, frame);
+	else
+		StoreHandlers::ClockLogo(widget, role, frame);
+}
+
+#undef HOOK_VARIANT
+
+extern "C" char __start_hook_clock_ip[], __stop_hook_clock_ip[];
+extern "C" char __start_hook_clock_noip[], __stop_hook_clock_noip[];
+extern "C" char __start_hook_hen_ip[], __stop_hook_hen_ip[];
+extern "C" char __start_hook_hen_noip[], __stop_hook_hen_noip[];
+extern "C" char __start_hook_runtime_flags[], __stop_hook_runtime_flags[];
+
+namespace
+{
+	typedef void(*Dispatch)(Widget*, WidgetRole, const Frame&);
+
+	struct Variant
+	{
+		const char* name;
+		Dispatch dispatch;
+		bool isHen;
+		bool ipTextDisabled;
+		size_t size;
+	};
+
+	// roughly what the hook sees in a frame: a few hundred widgets, a handful of them ours
+	std::vector<WidgetRole> MakeRoleMix(size_t count, unsigned targetPercent)
+	{
+		std::mt19937 random(4321);
+		std::vector<WidgetRole> roles;
+		roles.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			WidgetRole role = ROLE_NONE;
+			if (random() % 100 < targetPercent)
+				role = static_cast<WidgetRole>(ROLE_NONE + 1 + random() % (ROLE_COUNT - 1));
+			roles.push_back(role);
+		}
+		return roles;
+	}
+
+	// what the hook does with a classified widget: ROLE_NONE never reaches the dispatcher
+	void DrawAll(Dispatch dispatch, const std::vector<WidgetRole>& roles, std::vector<Widget>& widgets, const Frame& frame)
+	{
+		for (size_t i = 0; i < roles.size(); i++)
+		{
+			if (roles[i] != ROLE_NONE)
+				dispatch(&widgets[i], roles[i], frame);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	const size_t widgetCount = quick ? 400 : 2000;
+	const int passes = quick ? 1 : 20000;
+
+	Variant variants[] =
+	{
+		{ "clock, IP text", DispatchClockIp, false, false, static_cast<size_t>(__stop_hook_clock_ip - __start_hook_clock_ip) },
+		{ "clock, no IP text", DispatchClockNoIp, false, true, static_cast<size_t>(__stop_hook_clock_noip - __start_hook_clock_noip) },
+		{ "HEN, IP text", DispatchHenIp, true, false, static_cast<size_t>(__stop_hook_hen_ip - __start_hook_hen_ip) },
+		{ "HEN, no IP text", DispatchHenNoIp, true, true, static_cast<size_t>(__stop_hook_hen_noip - __start_hook_hen_noip) },
+	};
+	size_t runtimeSize = static_cast<size_t>(__stop_hook_runtime_flags - __start_hook_runtime_flags);
+
+	Frame frame{};
+	frame.gamebootAlpha = 0.75f;
+	for (int role = 0; role < ROLE_COUNT; role++)
+		frame.logoAlpha[role] = role / 16.f;
+
+	std::vector<WidgetRole> roles = MakeRoleMix(widgetCount, 3);
+
+	// every variant has to leave the widgets exactly as the runtime-flag dispatcher does with its flags set
+	for (const Variant& variant : variants)
+	{
+		std::vector<Widget> expected(widgetCount, Widget{ 0.5f, 0.5f });
+		std::vector<Widget> actual(widgetCount, Widget{ 0.5f, 0.5f });
+		g_isHen = variant.isHen;
+		g_isIpTextDisabled = variant.ipTextDisabled;
+		DrawAll(DispatchRuntimeFlags, roles, expected, frame);
+		DrawAll(variant.dispatch, roles, actual, frame);
+		for (size_t i = 0; i < widgetCount; i++)
+		{
+			CHECK_EQ(actual[i].metaAlpha, expected[i].metaAlpha);
+			CHECK_EQ(actual[i].alpha, expected[i].alpha);
+		}
+
+		CHECK(variant.size > 0);
+	}
+
+	// HEN drops the clock and gameboot branches, so its variants can't come out bigger
+	CHECK(variants[2].size <= variants[0].size);
+	CHECK(variants[3].size <= variants[1].size);
+
+	if (quick)
+		return check::Result();
+
+	std::printf("hook variants, code size\n");
+	for (const Variant& variant : variants)
+		std::printf("  %-40s %10zu bytes\n", variant.name, variant.size);
+	std::printf("  %-40s %10zu bytes\n", "flags tested per call", runtimeSize);
+
+	uint64_t operations = static_cast<uint64_t>(widgetCount) * passes;
+	std::printf("hook variants, %zu widgets (3%% targets) x %d passes, per widget drawn\n", widgetCount, passes);
+	std::vector<Widget> widgets(widgetCount, Widget{ 0.f, 0.f });
+
+	// both go through a pointer the compiler can't see through, as the detour's call into the hook does
+	Dispatch volatile dispatch = nullptr;
+	for (const Variant& variant : variants)
+	{
+		g_isHen = variant.isHen;
+		g_isIpTextDisabled = variant.ipTextDisabled;
+
+		dispatch = variant.dispatch;
+		bench::Report(variant.name, bench::Measure(operations, 5, [&] {
+			for (int pass = 0; pass < passes; pass++)
+				DrawAll(dispatch, roles, widgets, frame);
+			bench::Consume(widgets[0].alpha);
+		}));
+
+		dispatch = DispatchRuntimeFlags;
+		bench::Report("  same flags, tested per call", bench::Measure(operations, 5, [&] {
+			for (int pass = 0; pass < passes; pass++)
+				DrawAll(dispatch, roles, widgets, frame);
+			bench::Consume(widgets[0].alpha);
+		}));
+	}
+
+	return check::Result();
+}
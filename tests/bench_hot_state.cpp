@@ -0,0 +1,239 @@
+// Cache behaviour of the draw hook's hot state. Two cases:
+// - Between two of our draw calls the VSH draws other widgets and our lines get evicted. Every call here
+//   starts with the same lines flushed, then does the hook's reads and writes on one RenderState line, or on
+//   seven separate globals with cold data between them as they were before.
+// - The watcher thread stores to its fields while the render thread works. The render fields either share a
+//   line with the watcher's, as adjacent globals did, or sit apart as RenderState and WatcherState keep them.
+// Host lines are 64 bytes and host caches aren't the PPU's, so only the ratios carry over.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HOT_STATE_CAN_FLUSH 1
+#endif
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "render_state.hpp"
+
+namespace
+{
+	// The PPE is in order and stalls on each miss in turn, where the host overlaps them. The cold runs wait
+	// for every load before the next one to keep that from hiding the difference.
+	struct OutOfOrder
+	{
+		static void Wait() {}
+	};
+
+#ifdef HOT_STATE_CAN_FLUSH
+	struct InOrder
+	{
+		static void Wait() { _mm_lfence(); }
+	};
+#endif
+
+	// what one draw call does with the hot state: the epoch check, the counters, and the per-epoch reads
+	template<typename Order = OutOfOrder, typename State>
+	uint64_t TouchLikeHook(State& state, uint64_t timebase)
+	{
+		uint64_t sum = 0;
+		if (timebase - state.frameEpochTicks() >= 8000)
+			state.frameEpochTicks() = timebase;
+		Order::Wait();
+		state.frameCalls()++;
+		Order::Wait();
+		state.frameTargetCalls() += timebase & 1;
+		Order::Wait();
+		state.frameTicks() += 40;
+		Order::Wait();
+		sum += state.cachedClockState();
+		Order::Wait();
+		sum += state.pulseStart_us();
+		Order::Wait();
+		sum += state.resumeSerial();
+		return sum;
+	}
+
+	RenderState g_packed;
+
+	struct PackedState
+	{
+		uint64_t& frameEpochTicks() { return g_packed.frameEpochTicks; }
+		uint32_t& frameCalls() { return g_packed.frameCalls; }
+		uint32_t& frameTargetCalls() { return g_packed.frameTargetCalls; }
+		uint64_t& frameTicks() { return g_packed.frameTicks; }
+		uint32_t cachedClockState() const { return g_packed.cachedClockState; }
+		uint64_t pulseStart_us() const { return g_packed.pulse.start_us; }
+		uint32_t resumeSerial() const { return g_packed.resumeSerial; }
+	};
+
+	// the same fields as separate globals, each followed by the kind of cold data (the 2 KB gIpBuffer, config)
+	// that used to sit between them
+	constexpr size_t COLD_GAP = 2048 + 128;
+	constexpr size_t HOT_FIELDS = 7;
+	alignas(128) char g_scattered[COLD_GAP * HOT_FIELDS];
+
+	struct ScatteredState
+	{
+		template<typename T>
+		static T& At(size_t field) { return *reinterpret_cast<T*>(g_scattered + field * COLD_GAP); }
+
+		uint64_t& frameEpochTicks() { return At<uint64_t>(0); }
+		uint32_t& frameCalls() { return At<uint32_t>(1); }
+		uint32_t& frameTargetCalls() { return At<uint32_t>(2); }
+		uint64_t& frameTicks() { return At<uint64_t>(3); }
+		uint32_t cachedClockState() const { return At<uint32_t>(4); }
+		uint64_t pulseStart_us() const { return At<uint64_t>(5); }
+		uint32_t resumeSerial() const { return At<uint32_t>(6); }
+	};
+
+#ifdef HOT_STATE_CAN_FLUSH
+	// both layouts' lines, whichever one is measured, so the flushing costs the same in both runs
+	void FlushHotLines()
+	{
+		_mm_clflush(reinterpret_cast<char*>(&g_packed));
+		_mm_clflush(reinterpret_cast<char*>(&g_packed) + 64);
+		for (size_t field = 0; field < HOT_FIELDS; field++)
+			_mm_clflush(g_scattered + field * COLD_GAP);
+		_mm_mfence();
+	}
+
+	template<typename State>
+	double MeasureCold(int calls)
+	{
+		State state;
+		return bench::Measure(calls, 5, [&] {
+			uint64_t sum = 0;
+			for (int i = 0; i < calls; i++)
+			{
+				FlushHotLines();
+				sum += TouchLikeHook<InOrder>(state, i * 3000ull);
+			}
+			bench::Consume(sum);
+		});
+	}
+#endif
+
+	// the render thread's per-call fields on the same line as a field the watcher thread stores to
+	struct PPU_CACHE_LINE_ALIGNED SharedLine
+	{
+		uint64_t frameEpochTicks;
+		uint32_t frameCalls;
+		uint32_t frameTargetCalls;
+		uint64_t frameTicks;
+		volatile uint64_t watcherHandle;
+		uint32_t cachedClockState;
+		uint32_t resumeSerial;
+		uint64_t pulseStart_us;
+	};
+
+	struct PPU_CACHE_LINE_ALIGNED WatcherLine
+	{
+		volatile uint64_t watcherHandle;
+	};
+
+	SharedLine g_shared;
+	WatcherLine g_watcherLine;
+
+	struct SharedState
+	{
+		uint64_t& frameEpochTicks() { return g_shared.frameEpochTicks; }
+		uint32_t& frameCalls() { return g_shared.frameCalls; }
+		uint32_t& frameTargetCalls() { return g_shared.frameTargetCalls; }
+		uint64_t& frameTicks() { return g_shared.frameTicks; }
+		uint32_t cachedClockState() const { return g_shared.cachedClockState; }
+		uint64_t pulseStart_us() const { return g_shared.pulseStart_us; }
+		uint32_t resumeSerial() const { return g_shared.resumeSerial; }
+		static volatile uint64_t& WatcherHandle() { return g_shared.watcherHandle; }
+	};
+
+	struct SplitState : PackedState
+	{
+		static volatile uint64_t& WatcherHandle() { return g_watcherLine.watcherHandle; }
+	};
+
+	// the render thread's calls while another thread keeps storing to a watcher field the hook doesn't read
+	template<typename State>
+	double MeasureContended(int calls)
+	{
+		std::atomic<bool> stop(false);
+		std::thread watcher([&] {
+			while (!stop.load(std::memory_order_relaxed))
+				State::WatcherHandle() = State::WatcherHandle() + 1;
+		});
+
+		State state;
+		double ns = bench::Measure(calls, 5, [&] {
+			uint64_t sum = 0;
+			for (int i = 0; i < calls; i++)
+				sum += TouchLikeHook(state, i * 3000ull);
+			bench::Consume(sum);
+		});
+
+		stop = true;
+		watcher.join();
+		return ns;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	const int coldCalls = quick ? 100 : 200000;
+	const int contendedCalls = quick ? 1000 : 20000000;
+
+	CHECK_EQ(alignof(RenderState), PPU_CACHE_LINE_SIZE);
+	CHECK_EQ(sizeof(RenderState), PPU_CACHE_LINE_SIZE);
+	static_assert(offsetof(SharedLine, watcherHandle) < 64, "the watcher field has to share a host line with the counters");
+
+	// both layouts have to end up in the same state before their timings mean anything
+	{
+		PackedState packed;
+		ScatteredState scattered;
+		ScatteredState::At<uint32_t>(4) = g_packed.cachedClockState;
+		uint64_t packedSum = 0, scatteredSum = 0;
+		for (int i = 0; i < 1000; i++)
+		{
+			packedSum += TouchLikeHook(packed, i * 3000ull);
+			scatteredSum += TouchLikeHook(scattered, i * 3000ull);
+		}
+		CHECK_EQ(packedSum, scatteredSum);
+		CHECK_EQ(packed.frameCalls(), 1000);
+		CHECK_EQ(scattered.frameCalls(), 1000);
+		CHECK_EQ(packed.frameTargetCalls(), scattered.frameTargetCalls());
+		CHECK_EQ(packed.frameEpochTicks(), scattered.frameEpochTicks());
+		CHECK_EQ(packed.frameTicks(), scattered.frameTicks());
+	}
+
+#ifdef HOT_STATE_CAN_FLUSH
+	double packedNs = MeasureCold<PackedState>(coldCalls);
+	double scatteredNs = MeasureCold<ScatteredState>(coldCalls);
+	if (!quick)
+	{
+		std::printf("hot state with its lines flushed before every call (both runs flush the same lines)\n");
+		bench::Report("one RenderState line", packedNs);
+		bench::Report("separate globals among cold data", scatteredNs);
+	}
+#else
+	if (!quick)
+		std::printf("hot state with its lines flushed: needs clflush, skipped on this host\n");
+#endif
+
+	double sharedNs = MeasureContended<SharedState>(contendedCalls);
+	double splitNs = MeasureContended<SplitState>(contendedCalls);
+	CHECK(g_shared.frameCalls > 0);
+
+	if (!quick)
+	{
+		// with one CPU the two threads take turns and never contend for the line
+		std::printf("hot state while another thread stores to a watcher field, per call\n");
+		if (std::thread::hardware_concurrency() < 2)
+			std::printf("  (one CPU: the threads never run at once, no difference to expect)\n");
+		bench::Report("render fields on the watcher's line", sharedNs);
+		bench::Report("render and watcher lines apart", splitNs);
+	}
+
+	return check::Result();
+}
@@ -0,0 +1,237 @@
+// Frame cost of the IP text in the draw hook, before and after it moved to the watcher thread. Before, the
+// hook regenerated the text itself every 3 s, building a dozen wstrings, and set it on ip_text every frame.
+// Now it loads the published snapshot and only copies it when the version moved. Each frame is timed
+// on its own; the worst one is the frame a refresh lands on.
+// The old path's netctl and xsetting calls can't run here and are stand-ins that only fill their buffers,
+// so on the console the old worst frame is worse still. HookStats.maxFrameTicks is the on-device figure.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "ip_text.hpp"
+
+namespace
+{
+	constexpr uint64_t FRAME_US = 16667;
+	constexpr uint64_t IP_TEXT_CHECK_INTERVAL_US = 3000000;
+	constexpr size_t WIDGETS_PER_FRAME = 200;
+	constexpr uint64_t START_US = 10 * IP_TEXT_CHECK_INTERVAL_US; // both paths refresh on the first frame
+
+	const wchar_t g_header[] = L"PS3™ Pro — System Watcher";
+
+	// what netctl_main_9A528B81 and GetNetworkConfig hand back, without the calls
+	void GetIp(char (&ip)[16]) { std::strcpy(ip, "192.168.1.20"); }
+	void GetDns(char (&primary)[16], char (&secondary)[16]) { std::strcpy(primary, "45.33.44.103"); std::strcpy(secondary, "8.8.8.8"); }
+
+	// GenerateIpText() as the hook ran it before the publisher, the two SDK calls swapped for the stand-ins
+	std::wstring GenerateIpTextInHook()
+	{
+		std::wstring text(g_header);
+		char ip[16]{0};
+		GetIp(ip);
+		std::wstring systemIpAddress = L"System IP Address: ";
+		std::wstring IpAddress = (strlen(ip) > 0) ? std::wstring(ip, ip + strlen(ip)) : L"0.0.0.0";
+		std::wstring serverName;
+		if (IpAddress != L"0.0.0.0") {
+			char primaryDns[16], secondaryDns[16];
+			GetDns(primaryDns, secondaryDns);
+			std::wstring dnsPrimary(primaryDns, primaryDns + strlen(primaryDns));
+			std::wstring dnsSecondary(secondaryDns, secondaryDns + strlen(secondaryDns));
+			if (dnsPrimary == L"185.194.142.4" || dnsSecondary == L"185.194.142.4") serverName = L"PlayStation Online Network Emulated";
+			else if (dnsPrimary == L"51.79.41.185" || dnsSecondary == L"51.79.41.185") serverName = L"PlayStation Online Returnal Games";
+			else if (dnsPrimary == L"146.190.205.197" || dnsSecondary == L"146.190.205.197") serverName = L"PlayStation Reborn";
+			else if (dnsPrimary == L"135.148.144.253" || dnsSecondary == L"135.148.144.253") serverName = L"PlayStation Rewired";
+			else if (dnsPrimary == L"128.140.0.23" || dnsSecondary == L"128.140.0.23") serverName = L"Project Neptune";
+			else if (dnsPrimary == L"45.7.228.197" || dnsSecondary == L"45.7.228.197") serverName = L"Open Spy";
+			else if (dnsPrimary == L"142.93.245.186" || dnsSecondary == L"142.93.245.186") serverName = L"The ArchStones";
+			else if (dnsPrimary == L"188.225.75.35" || dnsSecondary == L"188.225.75.35") serverName = L"WareHouse";
+			else if (dnsPrimary == L"64.20.35.146" || dnsSecondary == L"64.20.35.146") serverName = L"Home Headquarters";
+			else if (dnsPrimary == L"52.86.120.101" || dnsSecondary == L"52.86.120.101") serverName = L"Destination Home";
+			else if (dnsPrimary == L"45.33.44.103" || dnsSecondary == L"45.33.44.103") serverName = L"Go Central";
+			else serverName = L"PlayStation™ Network";
+		}
+		systemIpAddress += IpAddress;
+		text += L"\n";
+		if (!serverName.empty()) text += L"Online Server: " + serverName + L"\n";
+		text += systemIpAddress;
+		return text;
+	}
+
+	struct Widget
+	{
+		bool isIpText;
+		float metaAlpha;
+		std::wstring text; // paf::PhText keeps its own copy of what SetText() was given
+	};
+
+	std::vector<Widget> MakeFrame()
+	{
+		std::vector<Widget> widgets(WIDGETS_PER_FRAME, Widget{ false, 0.f, std::wstring() });
+		widgets[WIDGETS_PER_FRAME / 2].isIpText = true;
+		widgets[WIDGETS_PER_FRAME / 2].text.reserve(IP_TEXT_CAPACITY);
+		return widgets;
+	}
+
+	struct InHook
+	{
+		std::wstring cachedText;
+		uint64_t lastCheck_us = 0;
+
+		void Draw(std::vector<Widget>& widgets, uint64_t time_us)
+		{
+			for (Widget& widget : widgets)
+			{
+				if (time_us - lastCheck_us > IP_TEXT_CHECK_INTERVAL_US)
+				{
+					cachedText = GenerateIpTextInHook();
+					lastCheck_us = time_us;
+				}
+
+				if (widget.isIpText)
+				{
+					widget.metaAlpha = 1.f;
+					widget.text = cachedText;
+				}
+			}
+		}
+	};
+
+	struct Published
+	{
+		IpTextPublisher publisher;
+		uint32_t appliedVersion = 0;
+		uint64_t lastPublish_us = 0;
+
+		Published() { publisher.Reserve(); }
+
+		// the watcher thread's side, not part of any frame
+		void Refresh(uint64_t time_us)
+		{
+			if (publisher.Get()->version != 0 && time_us - lastPublish_us <= IP_TEXT_CHECK_INTERVAL_US)
+				return;
+			lastPublish_us = time_us;
+
+			char ip[16], primaryDns[16], secondaryDns[16];
+			GetIp(ip);
+			GetDns(primaryDns, secondaryDns);
+			IpTextBuilder& text = publisher.Begin(g_header, true);
+			AppendServerLine(text, L"Go Central");
+			AppendAddressLine(text, ip);
+			publisher.Publish();
+		}
+
+		void Draw(std::vector<Widget>& widgets, uint64_t)
+		{
+			for (Widget& widget : widgets)
+			{
+				if (!widget.isIpText)
+					continue;
+
+				widget.metaAlpha = 1.f;
+				const IpTextSnapshot* snapshot = publisher.Get();
+				if (snapshot->version != appliedVersion)
+				{
+					widget.text = snapshot->text;
+					appliedVersion = snapshot->version;
+				}
+			}
+		}
+	};
+
+	void Refresh(InHook&, uint64_t) {}
+	void Refresh(Published& path, uint64_t time_us) { path.Refresh(time_us); }
+
+	struct FrameCosts
+	{
+		double worst_ns;
+		double refreshMean_ns;
+		double otherMean_ns;
+	};
+
+	// Times every frame on its own, in each of `runs` runs, and keeps every frame's fastest run so that
+	// an interrupt landing on one frame doesn't become its cost. A frame the old path would refresh on
+	// counts as a refresh frame in both.
+	template<typename Path>
+	FrameCosts MeasureFrames(int frames, int runs)
+	{
+		std::vector<double> costs(frames, 0.0);
+		for (int run = 0; run < runs; run++)
+		{
+			Path path;
+			std::vector<Widget> widgets = MakeFrame();
+			for (int i = 0; i < frames; i++)
+			{
+				uint64_t time_us = START_US + i * FRAME_US;
+				Refresh(path, time_us);
+
+				auto start = std::chrono::steady_clock::now();
+				path.Draw(widgets, time_us);
+				double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+				if (run == 0 || ns < costs[i])
+					costs[i] = ns;
+			}
+			bench::Consume(widgets[WIDGETS_PER_FRAME / 2].text.size());
+		}
+
+		double worst = 0.0, refreshSum = 0.0, otherSum = 0.0;
+		int refreshFrames = 0;
+		uint64_t lastRefresh_us = 0;
+		for (int i = 0; i < frames; i++)
+		{
+			uint64_t time_us = START_US + i * FRAME_US;
+			worst = std::max(worst, costs[i]);
+			if (time_us - lastRefresh_us > IP_TEXT_CHECK_INTERVAL_US)
+			{
+				lastRefresh_us = time_us;
+				refreshSum += costs[i];
+				refreshFrames++;
+			}
+			else
+				otherSum += costs[i];
+		}
+		return FrameCosts{ worst, refreshSum / refreshFrames, otherSum / (frames - refreshFrames) };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	const int frames = quick ? 400 : 60 * 60 * 10;
+
+	// both paths have to put the same text on ip_text
+	{
+		std::vector<Widget> before = MakeFrame();
+		std::vector<Widget> after = MakeFrame();
+		InHook inHook;
+		Published published;
+		published.Refresh(START_US);
+		inHook.Draw(before, START_US);
+		published.Draw(after, START_US);
+		CHECK(before[WIDGETS_PER_FRAME / 2].text == after[WIDGETS_PER_FRAME / 2].text);
+		CHECK(after[WIDGETS_PER_FRAME / 2].text == L"PS3™ Pro — System Watcher\nOnline Server: Go Central\nSystem IP Address: 192.168.1.20");
+	}
+
+	FrameCosts before = MeasureFrames<InHook>(frames, quick ? 1 : 5);
+	FrameCosts after = MeasureFrames<Published>(frames, quick ? 1 : 5);
+	CHECK(before.worst_ns > 0.0 && after.worst_ns > 0.0);
+
+	if (quick)
+		return check::Result();
+
+	std::printf("IP text in the draw hook, %d frames of %zu widgets, a refresh every %llu s, per frame\n", frames, WIDGETS_PER_FRAME,
+		static_cast<unsigned long long>(IP_TEXT_CHECK_INTERVAL_US / 1000000));
+	std::printf("generated in the hook\n");
+	bench::Report("  worst frame", before.worst_ns);
+	bench::Report("  refresh frames, mean", before.refreshMean_ns);
+	bench::Report("  other frames, mean", before.otherMean_ns);
+	std::printf("published snapshot\n");
+	bench::Report("  worst frame", after.worst_ns);
+	bench::Report("  refresh frames, mean", after.refreshMean_ns);
+	bench::Report("  other frames, mean", after.otherMean_ns);
+
+	return check::Result();
+}
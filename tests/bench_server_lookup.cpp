@@ -0,0 +1,139 @@
+// Looks up configured DNS pairs the way the online server line did before the server table, a chain of
+// wstring compares against both addresses, and through ServerTable: parse once, then a binary search.
+// Run against the built-in 14 networks and against a table of a few thousand.
+
+#include <string>
+#include <vector>
+#include <random>
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "Utils/ServerTable.hpp"
+
+namespace
+{
+	// far past what the plugin declares, to see how the lookup scales; static, it doesn't fit a stack
+	constexpr size_t LARGE_TABLE_SERVERS = 2048;
+	typedef FixedServerTable<LARGE_TABLE_SERVERS, 32768> LargeServerTable;
+
+	struct ChainEntry
+	{
+		std::wstring dns;
+		std::wstring name;
+	};
+
+	// the `dnsPrimary == L"..." || dnsSecondary == L"..."` chain, one branch per network
+	const std::wstring* ChainLookup(const std::vector<ChainEntry>& chain, const std::wstring& dnsPrimary, const std::wstring& dnsSecondary)
+	{
+		for (const ChainEntry& entry : chain)
+			if (dnsPrimary == entry.dns || dnsSecondary == entry.dns)
+				return &entry.name;
+		return nullptr;
+	}
+
+	const wchar_t* TableLookup(const ServerTable& table, const char* dnsPrimary, const char* dnsSecondary)
+	{
+		for (const char* dns : { dnsPrimary, dnsSecondary })
+		{
+			uint32_t address;
+			if (const wchar_t* name = ServerTable::ParseIpv4(dns, 16, address) ? table.FindByDns(address) : nullptr)
+				return name;
+		}
+		return nullptr;
+	}
+
+	struct DnsPair
+	{
+		char primary[16];
+		char secondary[16];
+		std::wstring widePrimary, wideSecondary;
+	};
+
+	std::string AddressText(uint32_t address)
+	{
+		return std::to_string(address >> 24) + "." + std::to_string(address >> 16 & 0xFF) + "." + std::to_string(address >> 8 & 0xFF) + "." + std::to_string(address & 0xFF);
+	}
+
+	void Run(size_t serverCount, bool quick)
+	{
+		std::mt19937 random(serverCount);
+		static LargeServerTable table;
+		table.Clear();
+
+		std::vector<ChainEntry> chain;
+		std::vector<std::string> addresses;
+		std::string line;
+		while (chain.size() < serverCount)
+		{
+			std::string address = AddressText(random());
+			std::string name = "Server " + std::to_string(chain.size());
+			uint32_t parsed;
+			ServerTable::ParseIpv4(address.c_str(), address.size(), parsed);
+			if (table.FindByDns(parsed))
+				continue;
+
+			line = address + " " + name + "\n";
+			table.Feed(line.data(), line.size());
+			chain.push_back(ChainEntry{ std::wstring(address.begin(), address.end()), std::wstring(name.begin(), name.end()) });
+			addresses.push_back(address);
+		}
+		table.Finish();
+		CHECK_EQ(table.GetCount(), serverCount);
+		CHECK_EQ(table.GetDroppedCount(), 0);
+
+		// most consoles sit on a public DNS, some on a revival network as primary or secondary
+		std::vector<DnsPair> pairs(512);
+		for (DnsPair& pair : pairs)
+		{
+			std::string primary = AddressText(random()), secondary = "8.8.8.8";
+			unsigned kind = random() % 4;
+			if (kind == 1)
+				primary = addresses[random() % addresses.size()];
+			else if (kind == 2)
+				secondary = addresses[random() % addresses.size()];
+
+			snprintf(pair.primary, sizeof(pair.primary), "%s", primary.c_str());
+			snprintf(pair.secondary, sizeof(pair.secondary), "%s", secondary.c_str());
+			pair.widePrimary.assign(primary.begin(), primary.end());
+			pair.wideSecondary.assign(secondary.begin(), secondary.end());
+		}
+
+		for (const DnsPair& pair : pairs)
+		{
+			const std::wstring* expected = ChainLookup(chain, pair.widePrimary, pair.wideSecondary);
+			const wchar_t* actual = TableLookup(table, pair.primary, pair.secondary);
+			CHECK(expected ? (actual && *expected == actual) : !actual);
+		}
+
+		if (quick)
+			return;
+
+		const int passes = serverCount > 100 ? 20 : 2000;
+		uint64_t operations = static_cast<uint64_t>(pairs.size()) * passes;
+		std::printf("server lookup, %zu servers, %zu DNS pairs x %d passes\n", serverCount, pairs.size(), passes);
+
+		bench::Report("wstring compare chain", bench::Measure(operations, 5, [&] {
+			uintptr_t hits = 0;
+			for (int pass = 0; pass < passes; pass++)
+				for (const DnsPair& pair : pairs)
+					hits += reinterpret_cast<uintptr_t>(ChainLookup(chain, pair.widePrimary, pair.wideSecondary));
+			bench::Consume(hits);
+		}));
+
+		bench::Report("ServerTable parse + binary search", bench::Measure(operations, 5, [&] {
+			uintptr_t hits = 0;
+			for (int pass = 0; pass < passes; pass++)
+				for (const DnsPair& pair : pairs)
+					hits += reinterpret_cast<uintptr_t>(TableLookup(table, pair.primary, pair.secondary));
+			bench::Consume(hits);
+		}));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	Run(14, quick);
+	Run(LARGE_TABLE_SERVERS, quick);
+	return check::Result();
+}
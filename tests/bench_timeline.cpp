@@ -0,0 +1,89 @@
+// Cost of one pulse evaluation: Timeline::Evaluate against the state machine the draw hook advanced
+// before the timelines, both fed the same increasing clock.
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "Utils/Timeline.hpp"
+
+namespace
+{
+	constexpr uint64_t FADE_DURATION_US = 800000;
+	constexpr uint64_t VISIBLE_DURATION_US = 25000;
+	constexpr uint64_t INVISIBLE_DURATION_US = 600000;
+
+	constexpr Keyframe PULSE_KEYFRAMES[] =
+	{
+		{ 0, 0.f, nullptr },
+		{ FADE_DURATION_US, 1.f, Ease::Linear },
+		{ FADE_DURATION_US + VISIBLE_DURATION_US, 1.f, nullptr },
+		{ 2 * FADE_DURATION_US + VISIBLE_DURATION_US, 0.f, Ease::Linear },
+		{ 2 * FADE_DURATION_US + VISIBLE_DURATION_US + INVISIBLE_DURATION_US, 0.f, nullptr },
+	};
+
+	constexpr Timeline PULSE_TIMELINE(PULSE_KEYFRAMES, true);
+
+	// the pulse as the hook used to run it
+	struct PulseStateMachine
+	{
+		enum State { FADING_IN, VISIBLE, FADING_OUT, INVISIBLE };
+		State state = FADING_IN;
+		uint64_t changedAt_us = 0;
+
+		float Advance(uint64_t currentTime_us)
+		{
+			uint64_t elapsed_us = currentTime_us - changedAt_us;
+			float progress = elapsed_us / static_cast<float>(FADE_DURATION_US);
+			if (progress > 1.f) progress = 1.f;
+
+			float pulseAlpha = 0.f;
+			switch (state) {
+			case FADING_IN: pulseAlpha = progress;
+				if (elapsed_us >= FADE_DURATION_US) { state = VISIBLE; changedAt_us = currentTime_us; } break;
+			case VISIBLE: pulseAlpha = 1.f;
+				if (elapsed_us >= VISIBLE_DURATION_US) { state = FADING_OUT; changedAt_us = currentTime_us; } break;
+			case FADING_OUT: pulseAlpha = 1.f - progress;
+				if (elapsed_us >= FADE_DURATION_US) { state = INVISIBLE; changedAt_us = currentTime_us; } break;
+			case INVISIBLE: pulseAlpha = 0.f;
+				if (elapsed_us >= INVISIBLE_DURATION_US) { state = FADING_IN; changedAt_us = currentTime_us; } break;
+			}
+			return pulseAlpha;
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	const uint64_t frames = quick ? 100000 : 20000000;
+	const uint64_t frame_us = 16667;
+
+	// the state machine only switches state on a draw, so it drifts by up to a frame per transition;
+	// over the first cycle both have to agree within one frame's worth of fade
+	{
+		PulseStateMachine machine;
+		for (uint64_t now = 0; now < PULSE_TIMELINE.GetDuration(); now += frame_us)
+			CHECK_NEAR(machine.Advance(now), PULSE_TIMELINE.Evaluate(0, now), 2.0 * frame_us / FADE_DURATION_US);
+	}
+
+	if (quick)
+		return check::Result();
+
+	std::printf("pulse alpha, %llu frames\n", static_cast<unsigned long long>(frames));
+
+	bench::Report("state machine", bench::Measure(frames, 5, [&] {
+		PulseStateMachine machine;
+		float sum = 0.f;
+		for (uint64_t i = 0; i < frames; i++)
+			sum += machine.Advance(i * frame_us);
+		bench::Consume(sum);
+	}));
+
+	bench::Report("Timeline::Evaluate", bench::Measure(frames, 5, [&] {
+		float sum = 0.f;
+		for (uint64_t i = 0; i < frames; i++)
+			sum += PULSE_TIMELINE.Evaluate(0, i * frame_us);
+		bench::Consume(sum);
+	}));
+
+	return check::Result();
+}
@@ -0,0 +1,76 @@
+// Decodes pro.xml-sized headers with Utf8::Decode and with swprintf(L"%s"), which is how LoadIpText()
+// widened the header before: pure ASCII, the usual case, and text with some accents and symbols in it.
+// swprintf decodes through the C library's locale, so the C.UTF-8 one is needed for the mixed text;
+// without it only the ASCII input is compared.
+
+#include <clocale>
+#include <cwchar>
+#include <string>
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "Utils/Utf8.hpp"
+
+namespace
+{
+	constexpr size_t CAPACITY = 512; // gIpBuffer
+
+	std::string MakeHeader(bool mixed)
+	{
+		std::string header;
+		const char* ascii = "PS3 Pro | Custom Firmware 4.92 | System Watcher | ";
+		const char* symbols = "PS3\xE2\x84\xA2 Pro \xE2\x80\x94 Caf\xC3\xA9 \xC2\xB1 Se\xC3\xB1or | ";
+		while (header.size() < 400)
+			header += mixed ? symbols : ascii;
+		return header;
+	}
+
+	void Run(const char* label, const std::string& header, bool compare, bool quick)
+	{
+		static wchar_t decoded[CAPACITY];
+		static wchar_t printed[CAPACITY];
+
+		Utf8::DecodeResult result = Utf8::Decode(header.data(), header.size(), decoded, CAPACITY);
+		CHECK(!result.invalid && !result.truncated);
+		if (compare)
+		{
+			std::swprintf(printed, CAPACITY, L"%s", header.c_str());
+			CHECK(std::wcscmp(decoded, printed) == 0);
+		}
+
+		if (quick)
+			return;
+
+		const int iterations = 200000;
+		std::printf("%s, %zu bytes x %d\n", label, header.size(), iterations);
+
+		bench::Report("Utf8::Decode", bench::Measure(iterations, 5, [&] {
+			size_t total = 0;
+			for (int i = 0; i < iterations; i++)
+				total += Utf8::Decode(header.data(), header.size(), decoded, CAPACITY).written;
+			bench::Consume(total);
+		}));
+
+		if (!compare)
+			return;
+
+		bench::Report("swprintf(L\"%s\")", bench::Measure(iterations, 5, [&] {
+			int total = 0;
+			for (int i = 0; i < iterations; i++)
+				total += std::swprintf(printed, CAPACITY, L"%s", header.c_str());
+			bench::Consume(total);
+		}));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	bool utf8Locale = std::setlocale(LC_ALL, "C.UTF-8") != nullptr;
+	if (!utf8Locale)
+		std::printf("no C.UTF-8 locale, swprintf is only run on ASCII\n");
+
+	Run("ASCII header", MakeHeader(false), true, quick);
+	Run("mixed header", MakeHeader(true), utf8Locale, quick);
+	return check::Result();
+}
@@ -0,0 +1,117 @@
+// Replays a synthetic mix of widget names through the strncmp chain pafWidgetDrawThis_Hook used before
+// the perfect-hash dispatch, and through WidgetRoles::Classify.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+
+#include "bench.hpp"
+#include "check.hpp"
+#include "widget_roles.hpp"
+
+namespace
+{
+	// the chain as it was in the hook: a first pass to find out whether the widget is one of ours,
+	// then a second chain for which logo it is
+	WidgetRole StrncmpClassify(const char* widgetName)
+	{
+		if (strncmp(widgetName, "ip_text", 7) == 0)
+			return ROLE_IP_TEXT;
+
+		if (strncmp(widgetName, "enhanced_game_text", 18) == 0)
+			return ROLE_ENHANCED_GAME_TEXT;
+
+		if (strncmp(widgetName, "pslogo", 6) == 0 || strncmp(widgetName, "pslogo_ring", 11) == 0 ||
+			strncmp(widgetName, "performance_mode_text", 21) == 0 || strncmp(widgetName, "performance_mode_text_glow", 26) == 0 ||
+			strncmp(widgetName, "balanced_mode_text", 18) == 0 || strncmp(widgetName, "balanced_mode_text_glow", 23) == 0 ||
+			strncmp(widgetName, "power_saving_mode_text", 22) == 0 || strncmp(widgetName, "power_saving_mode_text_glow", 27) == 0)
+		{
+			if (strncmp(widgetName, "pslogo_ring", 11) == 0) return ROLE_PSLOGO_RING;
+			else if (strncmp(widgetName, "pslogo", 6) == 0) return ROLE_PSLOGO;
+			else if (strncmp(widgetName, "performance_mode_text_glow", 26) == 0) return ROLE_PERFORMANCE_MODE_TEXT_GLOW;
+			else if (strncmp(widgetName, "performance_mode_text", 21) == 0) return ROLE_PERFORMANCE_MODE_TEXT;
+			else if (strncmp(widgetName, "balanced_mode_text_glow", 23) == 0) return ROLE_BALANCED_MODE_TEXT_GLOW;
+			else if (strncmp(widgetName, "balanced_mode_text", 18) == 0) return ROLE_BALANCED_MODE_TEXT;
+			else if (strncmp(widgetName, "power_saving_mode_text_glow", 27) == 0) return ROLE_POWER_SAVING_MODE_TEXT_GLOW;
+			else if (strncmp(widgetName, "power_saving_mode_text", 22) == 0) return ROLE_POWER_SAVING_MODE_TEXT;
+		}
+
+		return ROLE_NONE;
+	}
+
+	// roughly what an XMB frame draws: a few hundred icons, labels and frames, a handful of which are ours
+	std::vector<std::string> MakeWidgetMix(size_t count, unsigned targetPercent)
+	{
+		static const char* const roots[] =
+		{
+			"item_icon", "item_text", "item_sub_text", "page_bg", "menu_frame", "category_icon",
+			"info_panel", "option_text", "wave", "focus_frame", "clock_text", "battery_icon",
+			"title_text", "scroll_bar", "notification_text", "user_icon", "bg", "pane",
+		};
+		static const char* const targets[] =
+		{
+			"ip_text", "enhanced_game_text", "pslogo", "pslogo_ring", "performance_mode_text",
+			"performance_mode_text_glow", "balanced_mode_text", "balanced_mode_text_glow",
+			"power_saving_mode_text", "power_saving_mode_text_glow",
+		};
+
+		std::mt19937 random(1234);
+		std::vector<std::string> names;
+		names.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (random() % 100 < targetPercent)
+			{
+				names.push_back(targets[random() % (sizeof(targets) / sizeof(targets[0]))]);
+				continue;
+			}
+
+			std::string name = roots[random() % (sizeof(roots) / sizeof(roots[0]))];
+			if (random() % 2)
+				name += "_" + std::to_string(random() % 64);
+			names.push_back(name);
+		}
+		return names;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = bench::IsQuick(argc, argv);
+	const size_t widgetCount = quick ? 400 : 2000;
+	const int passes = quick ? 1 : 20000;
+
+	std::vector<std::string> names = MakeWidgetMix(widgetCount, 3);
+
+	// both dispatchers have to agree before their timings mean anything
+	for (const std::string& name : names)
+		CHECK_EQ(WidgetRoles::Classify(name.c_str(), name.size()), StrncmpClassify(name.c_str()));
+
+	for (size_t i = 1; i < WidgetRoles::kEntryCount; i++)
+		CHECK_EQ(WidgetRoles::Classify(WidgetRoles::kEntries[i].name, WidgetRoles::kEntries[i].length), WidgetRoles::kEntries[i].role);
+
+	if (quick)
+		return check::Result();
+
+	uint64_t operations = static_cast<uint64_t>(names.size()) * passes;
+	std::printf("widget dispatch, %zu names (3%% targets) x %d passes\n", names.size(), passes);
+
+	bench::Report("strncmp chain", bench::Measure(operations, 5, [&] {
+		uint32_t hits = 0;
+		for (int pass = 0; pass < passes; pass++)
+			for (const std::string& name : names)
+				hits += StrncmpClassify(name.c_str());
+		bench::Consume(hits);
+	}));
+
+	bench::Report("perfect hash (WidgetRoles::Classify)", bench::Measure(operations, 5, [&] {
+		uint32_t hits = 0;
+		for (int pass = 0; pass < passes; pass++)
+			for (const std::string& name : names)
+				hits += WidgetRoles::Classify(name.c_str(), name.size());
+		bench::Consume(hits);
+	}));
+
+	return check::Result();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertion helpers for the host tests: a failed check is reported and counted, the test
+// keeps going so one run shows every failure, and main() returns CheckResult().
+namespace check
+{
+	inline int& Failures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+
+	inline int Result()
+	{
+		if (Failures())
+			std::fprintf(stderr, "%d check(s) failed\n", Failures());
+		return Failures() ? 1 : 0;
+	}
+}
+
+#define CHECK(condition) \
+	do { if (!(condition)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); check::Failures()++; } } while (0)
+
+#define CHECK_EQ(actual, expected) \
+	do { \
+		long long actualValue_ = static_cast<long long>(actual), expectedValue_ = static_cast<long long>(expected); \
+		if (actualValue_ != expectedValue_) { \
+			std::fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #actual, #expected, actualValue_, expectedValue_); \
+			check::Failures()++; \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	do { \
+		double actualValue_ = (actual), expectedValue_ = (expected); \
+		if (actualValue_ < expectedValue_ - (tolerance) || actualValue_ > expectedValue_ + (tolerance)) { \
+			std::fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %f vs %f\n", __FILE__, __LINE__, #actual, #expected, actualValue_, expectedValue_); \
+			check::Failures()++; \
+		} \
+	} while (0)
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+// host stand-in, same contract as the PPU version: returns the value found at `ea`
+static inline uint32_t cellAtomicCompareAndSwap32(uint32_t* ea, uint32_t compare, uint32_t value)
+{
+	return __sync_val_compare_and_swap(ea, compare, value);
+}
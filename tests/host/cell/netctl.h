@@ -0,0 +1,15 @@
+#pragma once
+
+// host stand-in: the netctl states and handler events with the SDK's names and values, none of the calls
+#define CELL_NET_CTL_STATE_Disconnected 0
+#define CELL_NET_CTL_STATE_Connecting 1
+#define CELL_NET_CTL_STATE_IPObtaining 2
+#define CELL_NET_CTL_STATE_IPObtained 3
+
+#define CELL_NET_CTL_EVENT_CONNECT_REQ 0
+#define CELL_NET_CTL_EVENT_ESTABLISH 1
+#define CELL_NET_CTL_EVENT_GET_IP 2
+#define CELL_NET_CTL_EVENT_DISCONNECT_REQ 3
+#define CELL_NET_CTL_EVENT_ERROR 4
+#define CELL_NET_CTL_EVENT_LINK_DISCONNECTED 5
+#define CELL_NET_CTL_EVENT_AUTH_TIMEOUT 6
@@ -0,0 +1,6 @@
+#pragma once
+
+// host stand-in: the network stack's error codes are the host's errno values
+#include <errno.h>
+
+#define SYS_NET_ECONNREFUSED ECONNREFUSED
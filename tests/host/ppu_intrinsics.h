@@ -0,0 +1,5 @@
+#pragma once
+
+// host stand-in for the PPU intrinsics the plugin's portable code uses
+#define __lwsync() __sync_synchronize()
+#define __sync() __sync_synchronize()
@@ -0,0 +1,6 @@
+#pragma once
+
+// host stand-in: libnet's socketpoll() is poll()
+#include_next <sys/poll.h>
+
+inline int socketpoll(pollfd* fds, nfds_t count, int timeout_ms) { return poll(fds, count, timeout_ms); }
@@ -0,0 +1,24 @@
+#pragma once
+
+// host stand-in: the host's sockets with the libnet extras, SO_NBIO for non-blocking mode and socketclose()
+#include_next <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SO_NBIO 0x1100
+
+inline int socketclose(int s) { return close(s); }
+
+inline int HostSetSockOpt(int s, int level, int name, const void* value, socklen_t length)
+{
+	if (level != SOL_SOCKET || name != SO_NBIO)
+		return setsockopt(s, level, name, value, length);
+
+	int flags = fcntl(s, F_GETFL, 0);
+	if (flags < 0)
+		return -1;
+	flags = *static_cast<const int*>(value) ? flags | O_NONBLOCK : flags & ~O_NONBLOCK;
+	return fcntl(s, F_SETFL, flags);
+}
+
+#define setsockopt HostSetSockOpt
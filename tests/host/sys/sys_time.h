@@ -0,0 +1,13 @@
+#pragma once
+
+// host stand-in: Timer.hpp only needs the declarations that the portable code never calls, PingProbe times
+// its handshakes with the system time
+#include <stdint.h>
+#include <time.h>
+
+inline uint64_t sys_time_get_system_time()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// host stand-in, Timer.hpp only needs the declarations that the portable code never calls
+#include <stdint.h>
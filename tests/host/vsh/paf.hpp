@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+// host stand-in: the vector types Timer.hpp's declarations name and the libc math its easing
+// functions call, nothing of paf itself
+namespace paf
+{
+	struct vec2 { float x, y; };
+	struct vec3 { float x, y, z; };
+	struct vec4 { float x, y, z, w; };
+}
+
+namespace stdc
+{
+	inline float f_sinf(float x) { return std::sin(x); }
+	inline float f_cosf(float x) { return std::cos(x); }
+	inline float sqrtf(float x) { return std::sqrt(x); }
+	inline double pow(double x, double y) { return std::pow(x, y); }
+	inline double fabs(double x) { return std::fabs(x); }
+}
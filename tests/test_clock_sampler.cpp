@@ -0,0 +1,294 @@
+// ClockSampler against a scripted lv1 peek: how often it peeks while the clocks hold (the back-off), that
+// a changed reading has to repeat before it's published (the hysteresis), Tighten(), and the history
+// queries on top of the samples.
+
+#include <cstring>
+
+#include "check.hpp"
+#include "Utils/ClockSampler.hpp"
+
+namespace
+{
+	constexpr uint64_t GPU_CORE_CLOCK = 0x28000004028;
+	constexpr uint64_t GPU_VRAM_CLOCK = 0x28000004010;
+	constexpr uint64_t SECOND = 1000000;
+
+	// what the hypervisor would answer: the multiplier sits in byte 6 of the big-endian word, which is
+	// whatever byte 6 of the value is in memory on the host
+	struct ScriptedClocks
+	{
+		uint8_t coreMultiplier;  // x 50 MHz
+		uint8_t vramMultiplier;  // x 25 MHz
+		uint32_t peeks;
+		uint64_t badAddresses;
+	};
+
+	ScriptedClocks g_clocks;
+
+	uint64_t ScriptedPeek(uint64_t address)
+	{
+		g_clocks.peeks++;
+		uint8_t bytes[8]{};
+		if (address == GPU_CORE_CLOCK)
+			bytes[6] = g_clocks.coreMultiplier;
+		else if (address == GPU_VRAM_CLOCK)
+			bytes[6] = g_clocks.vramMultiplier;
+		else
+			g_clocks.badAddresses++;
+
+		uint64_t value;
+		std::memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	void SetClocks(uint32_t core_MHz, uint32_t vram_MHz)
+	{
+		g_clocks.coreMultiplier = static_cast<uint8_t>(core_MHz / 50);
+		g_clocks.vramMultiplier = static_cast<uint8_t>(vram_MHz / 25);
+	}
+
+	void Reset(uint32_t core_MHz, uint32_t vram_MHz)
+	{
+		g_clocks = ScriptedClocks{};
+		SetClocks(core_MHz, vram_MHz);
+	}
+
+	void TestClassify()
+	{
+		CHECK_EQ(ClockSampler::Classify(500, 650), CLOCK_STANDARD);
+		CHECK_EQ(ClockSampler::Classify(550, 700), CLOCK_OVERCLOCK);
+		CHECK_EQ(ClockSampler::Classify(500, 700), CLOCK_OVERCLOCK);
+		CHECK_EQ(ClockSampler::Classify(550, 650), CLOCK_OVERCLOCK);
+		CHECK_EQ(ClockSampler::Classify(450, 600), CLOCK_UNDERCLOCK);
+		CHECK_EQ(ClockSampler::Classify(500, 600), CLOCK_UNDERCLOCK);
+		CHECK_EQ(ClockSampler::Classify(550, 600), CLOCK_BALANCED);
+		CHECK_EQ(ClockSampler::Classify(450, 700), CLOCK_BALANCED);
+		CHECK_EQ(ClockSampler::Classify(0, 650), CLOCK_ERROR);
+		CHECK_EQ(ClockSampler::Classify(500, 0), CLOCK_ERROR);
+	}
+
+	void TestFirstSample()
+	{
+		Reset(550, 700);
+		ClockSampler sampler(ScriptedPeek);
+		CHECK_EQ(sampler.GetState(), CLOCK_STANDARD);
+		CHECK_EQ(sampler.GetCoreMHz(), 0);
+		uint64_t elapsed;
+		CHECK(!sampler.GetTimeSinceChange(SECOND, elapsed));
+
+		// the first one is published as it is, there's nothing to hold it against
+		CHECK(sampler.Update(SECOND));
+		CHECK_EQ(g_clocks.peeks, 2);
+		CHECK_EQ(g_clocks.badAddresses, 0);
+		CHECK_EQ(sampler.GetPeekCount(), 2);
+		CHECK_EQ(sampler.GetState(), CLOCK_OVERCLOCK);
+		ClockReading reading = sampler.GetReading();
+		CHECK_EQ(reading.core_MHz, 550);
+		CHECK_EQ(reading.vram_MHz, 700);
+		CHECK(sampler.GetTimeSinceChange(3 * SECOND, elapsed));
+		CHECK_EQ(elapsed, 2 * SECOND);
+	}
+
+	void TestBackOff()
+	{
+		Reset(500, 650);
+		ClockSampler sampler(ScriptedPeek);
+		uint64_t now = SECOND;
+		CHECK(sampler.Update(now));
+
+		// steady clocks: the interval doubles from 1 s up to 32 s, and nothing is peeked in between
+		uint64_t expected = ClockSampler::MinInterval_us;
+		uint32_t samples = 1;
+		for (int i = 0; i < 8; i++)
+		{
+			CHECK_EQ(sampler.GetInterval(), expected);
+			uint32_t peeks = g_clocks.peeks;
+			CHECK(!sampler.Update(now + expected - 1));
+			CHECK_EQ(g_clocks.peeks, peeks);
+
+			now += expected;
+			CHECK(sampler.Update(now));
+			CHECK_EQ(g_clocks.peeks, peeks + 2);
+			samples++;
+			expected = expected * 2 > ClockSampler::MaxInterval_us ? ClockSampler::MaxInterval_us : expected * 2;
+		}
+		CHECK_EQ(sampler.GetInterval(), ClockSampler::MaxInterval_us);
+		CHECK_EQ(sampler.GetSampleCount(), samples);
+
+		// an hour of steady clocks, polled every frame-ish, costs a couple of hundred peeks
+		uint32_t peeks = g_clocks.peeks;
+		uint64_t end = now + 3600 * SECOND;
+		for (; now < end; now += 16000)
+			sampler.Update(now);
+		uint32_t hourPeeks = g_clocks.peeks - peeks;
+		CHECK(hourPeeks >= 2 * (3600 / 32) && hourPeeks <= 2 * (3600 / 32 + 1));
+	}
+
+	void TestHysteresis()
+	{
+		Reset(500, 650);
+		ClockSampler sampler(ScriptedPeek);
+		uint64_t now = SECOND;
+		sampler.Update(now);
+		for (int i = 0; i < 4; i++)
+		{
+			now += sampler.GetInterval();
+			sampler.Update(now);
+		}
+		CHECK(sampler.GetInterval() > ClockSampler::MinInterval_us);
+
+		// one odd peek isn't published, but the sampler comes back for it at the minimum interval
+		SetClocks(550, 700);
+		now += sampler.GetInterval();
+		CHECK(sampler.Update(now));
+		CHECK(sampler.IsConfirming());
+		CHECK_EQ(sampler.GetState(), CLOCK_STANDARD);
+		CHECK_EQ(sampler.GetInterval(), ClockSampler::MinInterval_us);
+
+		// it didn't repeat: dismissed, and counted
+		SetClocks(500, 650);
+		now += sampler.GetInterval();
+		sampler.Update(now);
+		CHECK(!sampler.IsConfirming());
+		CHECK_EQ(sampler.GetState(), CLOCK_STANDARD);
+		CHECK_EQ(sampler.GetRejectedCount(), 1);
+
+		// two different odd readings in a row don't confirm each other either
+		SetClocks(550, 700);
+		now += sampler.GetInterval();
+		sampler.Update(now);
+		SetClocks(450, 600);
+		now += sampler.GetInterval();
+		sampler.Update(now);
+		CHECK_EQ(sampler.GetState(), CLOCK_STANDARD);
+		CHECK_EQ(sampler.GetRejectedCount(), 2);
+		CHECK(sampler.IsConfirming());
+
+		// the same one twice is a change
+		uint64_t changedAt = now + sampler.GetInterval();
+		now = changedAt;
+		CHECK(sampler.Update(now));
+		CHECK(!sampler.IsConfirming());
+		CHECK_EQ(sampler.GetState(), CLOCK_UNDERCLOCK);
+		CHECK_EQ(sampler.GetCoreMHz(), 450);
+		CHECK_EQ(sampler.GetVramMHz(), 600);
+		CHECK_EQ(sampler.GetInterval(), ClockSampler::MinInterval_us);
+		uint64_t elapsed;
+		CHECK(sampler.GetTimeSinceChange(now + 5 * SECOND, elapsed));
+		CHECK_EQ(elapsed, 5 * SECOND);
+
+		// from there it backs off again
+		now += sampler.GetInterval();
+		sampler.Update(now);
+		CHECK_EQ(sampler.GetInterval(), 2 * ClockSampler::MinInterval_us);
+
+		// an empty peek is a reading like any other, it has to repeat too
+		SetClocks(0, 0);
+		now += sampler.GetInterval();
+		sampler.Update(now);
+		CHECK_EQ(sampler.GetState(), CLOCK_UNDERCLOCK);
+		now += sampler.GetInterval();
+		sampler.Update(now);
+		CHECK_EQ(sampler.GetState(), CLOCK_ERROR);
+		CHECK_EQ(sampler.GetCoreMHz(), 0);
+	}
+
+	void TestTighten()
+	{
+		Reset(500, 650);
+		ClockSampler sampler(ScriptedPeek);
+		uint64_t now = SECOND;
+		sampler.Update(now);
+		for (int i = 0; i < 6; i++)
+		{
+			now += sampler.GetInterval();
+			sampler.Update(now);
+		}
+		CHECK_EQ(sampler.GetInterval(), ClockSampler::MaxInterval_us);
+
+		// back from a game: the next update samples right away and the back-off starts over
+		sampler.Tighten();
+		uint32_t peeks = g_clocks.peeks;
+		CHECK(sampler.Update(now + 10));
+		CHECK_EQ(g_clocks.peeks, peeks + 2);
+		CHECK_EQ(sampler.GetInterval(), 2 * ClockSampler::MinInterval_us);
+		CHECK(!sampler.Update(now + 20));
+		CHECK_EQ(g_clocks.peeks, peeks + 2);
+	}
+
+	void TestHistory()
+	{
+		Reset(500, 650);
+		ClockSampler sampler(ScriptedPeek);
+		ClockSample samples[8];
+		ClockWindowStats stats;
+		CHECK_EQ(sampler.GetRecentSamples(samples, 8), 0);
+		CHECK(!sampler.GetWindowStats(10 * SECOND, 10 * SECOND, stats));
+
+		// 500 MHz from 10 s, an unconfirmed 600 at 11 s, back to 500 at 12 s, then 600 for good from 13 s.
+		// Tightened before each so the back-off doesn't skip any of them
+		static const uint32_t cores[] = { 500, 600, 500, 600, 600 };
+		for (uint32_t i = 0; i < 5; i++)
+		{
+			SetClocks(cores[i], 650);
+			sampler.Tighten();
+			CHECK(sampler.Update((10 + i) * SECOND));
+		}
+		CHECK_EQ(sampler.GetCoreMHz(), 600);
+
+		// every sample is kept, unconfirmed ones included, newest first
+		size_t count = sampler.GetRecentSamples(samples, 8);
+		CHECK_EQ(count, 5);
+		CHECK_EQ(samples[0].time_us, 14 * SECOND);
+		CHECK_EQ(samples[4].time_us, 10 * SECOND);
+		CHECK_EQ(samples[3].reading.core_MHz, 600);
+		CHECK_EQ(sampler.GetRecentSamples(samples, 2), 2);
+
+		// over the last 6 s at 16 s: 500 held for 10-11 and 12-13 s, 600 for 11-12 and from 13 s on
+		CHECK(sampler.GetWindowStats(16 * SECOND, 6 * SECOND, stats));
+		CHECK_EQ(stats.samples, 5);
+		CHECK_EQ(stats.coreMin_MHz, 500);
+		CHECK_EQ(stats.coreMax_MHz, 600);
+		CHECK_EQ(stats.coreAvg_MHz, (500 * 2 + 600 * 4 + 3) / 6);
+		CHECK_EQ(stats.vramMin_MHz, 650);
+		CHECK_EQ(stats.vramAvg_MHz, 650);
+
+		// a window that starts after the older samples only weighs what held inside it
+		CHECK(sampler.GetWindowStats(16 * SECOND, 3 * SECOND, stats));
+		CHECK_EQ(stats.coreMin_MHz, 600);
+		CHECK_EQ(stats.coreAvg_MHz, 600);
+
+		// empty peeks are left out of the statistics, though the reading before one still held up to it
+		SetClocks(0, 0);
+		sampler.Tighten();
+		sampler.Update(15 * SECOND);
+		CHECK(sampler.GetWindowStats(17 * SECOND, 4 * SECOND, stats));
+		CHECK_EQ(stats.samples, 2);
+		CHECK_EQ(stats.coreMin_MHz, 600);
+		CHECK(!sampler.GetWindowStats(17 * SECOND, SECOND, stats));
+		CHECK_EQ(stats.samples, 0);
+
+		// the ring holds the last HistorySize samples
+		uint64_t now = 20 * SECOND;
+		for (size_t i = 0; i < ClockSampler::HistorySize + 10; i++)
+		{
+			SetClocks(i % 2 ? 500 : 550, 650);
+			sampler.Tighten();
+			sampler.Update(now += SECOND);
+		}
+		static ClockSample all[ClockSampler::HistorySize + 10];
+		CHECK_EQ(sampler.GetRecentSamples(all, ClockSampler::HistorySize + 10), ClockSampler::HistorySize);
+		CHECK_EQ(all[0].time_us, now);
+	}
+}
+
+int main()
+{
+	TestClassify();
+	TestFirstSample();
+	TestBackOff();
+	TestHysteresis();
+	TestTighten();
+	TestHistory();
+	return check::Result();
+}
@@ -0,0 +1,186 @@
+// DnsProbe against a scripted resolver: answers as gethostbyname() hands them out, in network order, for
+// PSN, for a revival network behind a forwarding router, and for blocklists, failures and a stop midway.
+
+#include <cstring>
+#include <cwchar>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "Utils/DnsProbe.hpp"
+
+namespace
+{
+	uint32_t Address(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { return (a << 24) | (b << 16) | (c << 8) | d; }
+
+	bool NameIs(const wchar_t* name, const wchar_t* expected) { return name && std::wcscmp(name, expected) == 0; }
+
+	const char* const HOSTS[] = { "a0.ww.np.dl.playstation.net", "auth.np.ac.playstation.net", "getprof.np.community.playstation.net" };
+	constexpr size_t HOST_COUNT = sizeof(HOSTS) / sizeof(HOSTS[0]);
+
+	// one host's answer the way the resolver lays it out: a hostent pointing at a null-terminated list
+	// of 4-byte addresses in network order
+	struct ScriptedAnswer
+	{
+		std::vector<uint8_t> bytes;
+		std::vector<char*> list;
+		hostent entry;
+	};
+
+	struct ScriptedResolver
+	{
+		std::map<std::string, ScriptedAnswer> answers;
+		std::vector<std::string> asked;
+		size_t stopAfter = ~size_t(0); // hosts answered before the probe thread is told to stop
+
+		void Answer(const char* host, std::initializer_list<uint32_t> addresses, int family = AF_INET)
+		{
+			ScriptedAnswer& answer = answers[host];
+			answer.bytes.clear();
+			for (uint32_t address : addresses)
+				for (int shift = 24; shift >= 0; shift -= 8)
+					answer.bytes.push_back(static_cast<uint8_t>(address >> shift));
+
+			answer.list.clear();
+			for (size_t i = 0; i < addresses.size(); i++)
+				answer.list.push_back(reinterpret_cast<char*>(&answer.bytes[i * 4]));
+			answer.list.push_back(nullptr);
+
+			answer.entry = hostent{};
+			answer.entry.h_addrtype = family;
+			answer.entry.h_length = 4;
+			answer.entry.h_addr_list = answer.list.data();
+		}
+	};
+
+	ScriptedResolver g_resolver;
+
+	hostent* Resolve(const char* host)
+	{
+		if (g_resolver.asked.size() >= g_resolver.stopAfter)
+			return nullptr;
+
+		g_resolver.asked.push_back(host);
+		auto answer = g_resolver.answers.find(host);
+		return answer != g_resolver.answers.end() ? &answer->second.entry : nullptr;
+	}
+
+	ServerTable& Table()
+	{
+		static FixedServerTable<64, 2048> table;
+		table.Clear();
+		const std::string text =
+			"45.33.44.103 Go Central\n"
+			"45.33.44.0/24 Go Central\n"
+			"64.20.35.146 Home Headquarters\n"
+			"198.51.100.0/26 Home Headquarters\n";
+		table.Feed(text.data(), text.size());
+		table.Finish();
+		return table;
+	}
+
+	DnsProbe::Result Run(const ServerTable& table)
+	{
+		g_resolver.asked.clear();
+		return DnsProbe::Run(HOSTS, HOST_COUNT, Resolve, table);
+	}
+
+	void TestRoutable()
+	{
+		CHECK(DnsProbe::IsRoutableAddress(Address(45, 33, 44, 103)));
+		CHECK(DnsProbe::IsRoutableAddress(Address(172, 32, 0, 1)));
+		CHECK(DnsProbe::IsRoutableAddress(Address(192, 169, 0, 1)));
+		for (uint32_t blocked : { Address(0, 0, 0, 0), Address(127, 0, 0, 1), Address(10, 1, 2, 3), Address(192, 168, 1, 1), Address(172, 16, 0, 1), Address(172, 31, 255, 255) })
+			CHECK(!DnsProbe::IsRoutableAddress(blocked));
+	}
+
+	void TestPsn()
+	{
+		// Sony's answers match nothing, the verdict keeps the first routable one to ping
+		g_resolver = ScriptedResolver{};
+		g_resolver.Answer(HOSTS[0], { Address(23, 45, 67, 89), Address(23, 45, 67, 90) });
+		g_resolver.Answer(HOSTS[1], { Address(104, 16, 0, 1) });
+		g_resolver.Answer(HOSTS[2], { Address(104, 16, 0, 2) });
+
+		DnsProbe::Result result = Run(Table());
+		CHECK(!result.name);
+		CHECK_EQ(result.address, Address(23, 45, 67, 89));
+		CHECK_EQ(g_resolver.asked.size(), HOST_COUNT);
+	}
+
+	void TestForwardedRevival()
+	{
+		// a router forwarding to the revival DNS: the first host gets PSN's answer, the second the server's
+		g_resolver = ScriptedResolver{};
+		g_resolver.Answer(HOSTS[0], { Address(23, 45, 67, 89) });
+		g_resolver.Answer(HOSTS[1], { Address(127, 0, 0, 1), Address(45, 33, 44, 20) });
+		g_resolver.Answer(HOSTS[2], { Address(64, 20, 35, 146) });
+
+		DnsProbe::Result result = Run(Table());
+		CHECK(NameIs(result.name, L"Go Central"));
+		CHECK_EQ(result.address, Address(45, 33, 44, 20));
+		CHECK_EQ(g_resolver.asked.size(), 2);
+
+		// only the listed ranges count: the /26 takes .63 but not .64
+		g_resolver = ScriptedResolver{};
+		g_resolver.Answer(HOSTS[0], { Address(198, 51, 100, 64) });
+		g_resolver.Answer(HOSTS[1], { Address(198, 51, 100, 63) });
+		result = Run(Table());
+		CHECK(NameIs(result.name, L"Home Headquarters"));
+		CHECK_EQ(result.address, Address(198, 51, 100, 63));
+
+		// the DNS server's own address without a range around it matches only itself
+		g_resolver = ScriptedResolver{};
+		g_resolver.Answer(HOSTS[0], { Address(64, 20, 35, 147) });
+		g_resolver.Answer(HOSTS[2], { Address(64, 20, 35, 146) });
+		result = Run(Table());
+		CHECK(NameIs(result.name, L"Home Headquarters"));
+		CHECK_EQ(result.address, Address(64, 20, 35, 146));
+	}
+
+	void TestUnusableAnswers()
+	{
+		// a blocklist answering with loopback and private addresses, an IPv6 answer and a failed lookup
+		g_resolver = ScriptedResolver{};
+		g_resolver.Answer(HOSTS[0], { Address(0, 0, 0, 0), Address(127, 0, 0, 1) });
+		g_resolver.Answer(HOSTS[1], { Address(45, 33, 44, 20) }, AF_INET6);
+		g_resolver.Answer(HOSTS[2], { Address(192, 168, 1, 1), Address(10, 0, 0, 1) });
+
+		DnsProbe::Result result = Run(Table());
+		CHECK(!result.name);
+		CHECK_EQ(result.address, 0);
+		CHECK_EQ(g_resolver.asked.size(), HOST_COUNT);
+
+		g_resolver = ScriptedResolver{};
+		g_resolver.Answer(HOSTS[1], {});
+		result = Run(Table());
+		CHECK(!result.name);
+		CHECK_EQ(result.address, 0);
+	}
+
+	void TestStop()
+	{
+		// the resolver answers nothing once the thread is stopping, the probe ends with what it had
+		g_resolver = ScriptedResolver{};
+		g_resolver.Answer(HOSTS[0], { Address(23, 45, 67, 89) });
+		g_resolver.Answer(HOSTS[1], { Address(45, 33, 44, 20) });
+		g_resolver.stopAfter = 1;
+
+		DnsProbe::Result result = Run(Table());
+		CHECK(!result.name);
+		CHECK_EQ(result.address, Address(23, 45, 67, 89));
+		CHECK_EQ(g_resolver.asked.size(), 1);
+	}
+}
+
+int main()
+{
+	TestRoutable();
+	TestPsn();
+	TestForwardedRevival();
+	TestUnusableAnswers();
+	TestStop();
+	return check::Result();
+}
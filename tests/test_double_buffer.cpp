@@ -0,0 +1,105 @@
+// DoubleBuffer: what readers see before and after publishes, and that Read() never returns a value torn by
+// a writer publishing concurrently.
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "check.hpp"
+#include "Utils/DoubleBuffer.hpp"
+
+namespace
+{
+	// every field derived from the first, a torn copy has them disagree
+	struct Sample
+	{
+		uint32_t values[16];
+	};
+
+	void TestPublish()
+	{
+		DoubleBuffer<Sample> buffer;
+		const Sample* initial = buffer.Get();
+		CHECK_EQ(initial->values[0], 0);
+
+		// Next() is never the buffer readers see
+		CHECK(&buffer.Next() != initial);
+		Sample& next = buffer.Next();
+		next.values[0] = 1;
+		CHECK_EQ(buffer.Get()->values[0], 0);
+
+		const Sample* published = buffer.Publish();
+		CHECK(published == &next);
+		CHECK(buffer.Get() == published);
+		CHECK_EQ(buffer.Read().values[0], 1);
+
+		// the two buffers alternate, an old pointer holds until the second publish after it
+		Sample value{};
+		value.values[0] = 2;
+		buffer.Publish(value);
+		CHECK(buffer.Get() == initial);
+		CHECK_EQ(published->values[0], 1);
+		value.values[0] = 3;
+		buffer.Publish(value);
+		CHECK(buffer.Get() == published);
+		CHECK_EQ(buffer.Get()->values[0], 3);
+	}
+
+	void TestInPlace()
+	{
+		// members with reserved storage keep it when filled in place
+		DoubleBuffer<std::wstring> buffer;
+		buffer.GetBuffer(0).reserve(256);
+		buffer.GetBuffer(1).reserve(256);
+
+		for (int i = 0; i < 10; i++)
+		{
+			std::wstring& next = buffer.Next();
+			next.assign(100, static_cast<wchar_t>(L'a' + i));
+			buffer.Publish();
+			CHECK(buffer.Get()->capacity() >= 256);
+			CHECK(*buffer.Get() == std::wstring(100, static_cast<wchar_t>(L'a' + i)));
+		}
+	}
+
+	void TestConcurrentRead()
+	{
+		DoubleBuffer<Sample> buffer;
+		std::atomic<bool> done(false);
+
+		std::thread writer([&] {
+			for (uint32_t serial = 1; serial <= 200000; serial++)
+			{
+				Sample& next = buffer.Next();
+				for (uint32_t& value : next.values)
+					value = serial;
+				buffer.Publish();
+			}
+			done = true;
+		});
+
+		uint32_t torn = 0, reads = 0, last = 0, backwards = 0;
+		while (!done || reads < 1000)
+		{
+			Sample copy = buffer.Read();
+			for (uint32_t value : copy.values)
+				torn += value != copy.values[0];
+			backwards += copy.values[0] < last;
+			last = copy.values[0];
+			reads++;
+		}
+		writer.join();
+
+		CHECK_EQ(torn, 0);
+		CHECK_EQ(backwards, 0);
+		CHECK_EQ(buffer.Read().values[15], 200000);
+	}
+}
+
+int main()
+{
+	TestPublish();
+	TestInPlace();
+	TestConcurrentRead();
+	return check::Result();
+}
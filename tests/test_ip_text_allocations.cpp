@@ -0,0 +1,160 @@
+// IpTextPublisher and the line formatters PublishIpText() uses: what the snapshots hold, and the heap
+// allocations across refreshes. Steady-state refreshes must not allocate at all.
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "check.hpp"
+#include "ip_text.hpp"
+
+namespace
+{
+	size_t g_allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+	g_allocations++;
+	if (void* block = std::malloc(size ? size : 1))
+		return block;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete[](void* block) noexcept { std::free(block); }
+void operator delete(void* block, size_t) noexcept { std::free(block); }
+void operator delete[](void* block, size_t) noexcept { std::free(block); }
+
+namespace
+{
+	// what the widgets end up showing, and where the header goes
+	void TestLines()
+	{
+		static IpTextPublisher publisher;
+		publisher.Reserve();
+		CHECK_EQ(publisher.Get()->version, 0);
+
+		IpTextBuilder& text = publisher.Begin(L"Header", false);
+		AppendServerLine(text, L"Xlink Kai");
+		AppendPingLine(text, 4, 42, 3, 0);
+		AppendAddressLine(text, "192.168.1.20");
+		CHECK(publisher.Publish());
+		CHECK(publisher.Get()->text == L"Online Server: Xlink Kai\nPing: 42 ms (±3 ms)\nSystem IP Address: 192.168.1.20");
+		CHECK(publisher.Get()->header == L"Header");
+		CHECK_EQ(publisher.Get()->headerLift, 3);
+		CHECK_EQ(publisher.Get()->version, 1);
+		CHECK_EQ(publisher.Get()->headerVersion, 1);
+
+		// one line less moves the header but leaves its text alone
+		IpTextBuilder& shorter = publisher.Begin(L"Header", false);
+		AppendAddressLine(shorter, nullptr);
+		CHECK(publisher.Publish());
+		CHECK(publisher.Get()->text == L"System IP Address: 0.0.0.0");
+		CHECK_EQ(publisher.Get()->headerLift, 1);
+		CHECK_EQ(publisher.Get()->version, 2);
+		CHECK_EQ(publisher.Get()->headerVersion, 2);
+
+		IpTextBuilder& same = publisher.Begin(L"Header", false);
+		AppendAddressLine(same, nullptr);
+		CHECK(!publisher.Publish());
+
+		// the debug plugin's ip_text carries the header itself
+		IpTextBuilder& inlined = publisher.Begin(L"Header", true);
+		AppendPingLine(inlined, 0, 0, 0, 0);
+		AppendPingLine(inlined, 3, 120, 40, 25);
+		AppendAddressLine(inlined, "10.0.0.7");
+		CHECK(publisher.Publish());
+		CHECK(publisher.Get()->text == L"Header\nPing: timeout\nPing: 120 ms (±40 ms, 25% loss)\nSystem IP Address: 10.0.0.7");
+		CHECK(publisher.Get()->header.empty());
+		CHECK_EQ(publisher.Get()->headerLift, 0);
+		CHECK_EQ(publisher.Get()->headerVersion, 3);
+	}
+
+	wchar_t g_header[IP_TEXT_HEADER_CAPACITY] = L"PS3™ Pro — System Watcher";
+	IpTextPublisher g_publisher;
+	IpTextBuilder g_scratch;
+
+	// the same lines GenerateIpText() writes, from what netctl and the probes would hand back
+	bool Publish(const char* ip, const wchar_t* server, uint32_t ping_ms, uint32_t jitter_ms, bool headerInline = false)
+	{
+		IpTextBuilder& text = g_publisher.Begin(g_header, headerInline);
+		AppendServerLine(text, server);
+		if (ping_ms)
+			AppendPingLine(text, 5, ping_ms, jitter_ms, ping_ms % 5 ? 0 : 20);
+		AppendAddressLine(text, ip);
+		return g_publisher.Publish();
+	}
+
+	void TestHarnessCountsAllocations()
+	{
+		// a string that wasn't reserved has to allocate to take the copy, or the counter isn't hooked up
+		size_t before = g_allocations;
+		std::wstring unreserved;
+		g_scratch.Clear();
+		g_scratch.Append(L"long enough to never fit a small-string buffer, whatever the library");
+		g_scratch.CopyTo(unreserved);
+		CHECK(g_allocations > before);
+	}
+
+	void TestRefreshesDontAllocate()
+	{
+		g_publisher.Reserve();
+
+		static const char* const ips[] = { "192.168.1.20", "10.0.0.7", "172.16.254.1", "255.255.255.255" };
+		static const wchar_t* const servers[] = { L"PlayStation™Network", L"Xlink Kai", L"PSONE Édition", L"Monster Hunter (モンハン)" };
+
+		size_t before = g_allocations;
+		uint32_t published = 0;
+		for (uint32_t refresh = 0; refresh < 10000; refresh++)
+			published += Publish(ips[refresh % 4], servers[(refresh / 3) % 4], refresh % 7 ? 20 + refresh % 300 : 0, refresh % 13);
+
+		CHECK_EQ(g_allocations - before, 0);
+		CHECK(published > 1000);
+		CHECK(g_publisher.Get()->text.find(L"Online Server: ") != std::wstring::npos);
+		CHECK(g_publisher.Get()->header == g_header);
+
+		// nothing changed, nothing published
+		Publish(ips[0], servers[0], 42, 3);
+		CHECK(!Publish(ips[0], servers[0], 42, 3));
+		CHECK_EQ(g_allocations - before, 0);
+	}
+
+	void TestOverflowDoesntAllocate()
+	{
+		// a header that fills the whole buffer, plus dynamic lines on top: truncated, never grown
+		for (size_t i = 0; i < IP_TEXT_HEADER_CAPACITY - 1; i++)
+			g_header[i] = L'a' + i % 26;
+		g_header[IP_TEXT_HEADER_CAPACITY - 1] = L'\0';
+
+		size_t before = g_allocations;
+		for (uint32_t refresh = 0; refresh < 100; refresh++)
+		{
+			IpTextBuilder& text = g_publisher.Begin(g_header, refresh % 2);
+			AppendPingLine(text, 1, refresh, 1, 0);
+			text.Append(L'x', IP_TEXT_CAPACITY);
+			CHECK(text.IsTruncated());
+			CHECK_EQ(text.GetLength(), IP_TEXT_CAPACITY - 1);
+			CHECK(g_publisher.Publish());
+			CHECK_EQ(g_publisher.Get()->text.size(), IP_TEXT_CAPACITY - 1);
+		}
+
+		CHECK_EQ(g_allocations - before, 0);
+	}
+}
+
+int main()
+{
+	TestLines();
+	TestHarnessCountsAllocations();
+	TestRefreshesDontAllocate();
+	TestOverflowDoesntAllocate();
+	std::printf("%zu allocations in total, all of them outside the refresh loops\n", g_allocations);
+	return check::Result();
+}
@@ -0,0 +1,167 @@
+// LatencyWindow: the median over the replies in the window, loss accounting as probes roll out of it, the
+// reply histogram and the RFC 3550 jitter estimate.
+
+#include "check.hpp"
+#include "Utils/LatencyWindow.hpp"
+
+namespace
+{
+	void TestMedian()
+	{
+		LatencyWindow<8> window;
+		uint32_t median = 42;
+		CHECK(!window.GetMedian(median));
+		CHECK_EQ(median, 42);
+
+		// odd count, fed out of order
+		for (uint32_t rtt : { 30000u, 10000u, 20000u })
+			window.AddReply(rtt);
+		CHECK(window.GetMedian(median));
+		CHECK_EQ(median, 20000);
+
+		// even count takes the lower of the two middle replies
+		window.AddReply(40000);
+		CHECK(window.GetMedian(median));
+		CHECK_EQ(median, 20000);
+
+		// losses aren't replies and don't pull the median
+		window.AddLoss();
+		window.AddLoss();
+		window.AddLoss();
+		CHECK(window.GetMedian(median));
+		CHECK_EQ(median, 20000);
+		CHECK_EQ(window.GetReplyCount(), 4);
+
+		// nothing but losses has no median
+		LatencyWindow<4> lossy;
+		lossy.AddLoss();
+		CHECK(!lossy.GetMedian(median));
+	}
+
+	void TestRolling()
+	{
+		LatencyWindow<4> window;
+		for (uint32_t rtt : { 100000u, 200000u, 300000u, 400000u })
+			window.AddReply(rtt);
+
+		// the oldest reply rolls out first
+		uint32_t median = 0;
+		window.AddReply(500000);
+		CHECK_EQ(window.GetCount(), 4);
+		CHECK(window.GetMedian(median));
+		CHECK_EQ(median, 300000);
+
+		window.AddReply(600000);
+		window.AddReply(700000);
+		window.AddReply(800000);
+		CHECK(window.GetMedian(median));
+		CHECK_EQ(median, 600000);
+	}
+
+	void TestLoss()
+	{
+		LatencyWindow<4> window;
+		CHECK_EQ(window.GetLossPercent(), 0);
+
+		window.AddReply(10000);
+		window.AddLoss();
+		CHECK_EQ(window.GetLossPercent(), 50);
+		window.AddLoss();
+		window.AddReply(10000);
+		CHECK_EQ(window.GetLossPercent(), 50);
+		CHECK_EQ(window.GetReplyCount(), 2);
+
+		// evicted losses stop counting: R L L R | R R leaves L R R R
+		window.AddReply(10000);
+		window.AddReply(10000);
+		CHECK_EQ(window.GetCount(), 4);
+		CHECK_EQ(window.GetLossPercent(), 25);
+		window.AddReply(10000);
+		CHECK_EQ(window.GetLossPercent(), 0);
+
+		// a window full of losses
+		for (int i = 0; i < 4; i++)
+			window.AddLoss();
+		CHECK_EQ(window.GetLossPercent(), 100);
+		CHECK_EQ(window.GetReplyCount(), 0);
+
+		// a reply that happens to equal the loss marker is still a reply
+		window.AddReply(LatencyWindow<4>::Lost);
+		CHECK_EQ(window.GetReplyCount(), 1);
+		CHECK_EQ(window.GetLossPercent(), 75);
+	}
+
+	void TestHistogram()
+	{
+		LatencyWindow<8> window;
+		for (size_t i = 0; i < LatencyWindow<8>::BucketCount; i++)
+			CHECK_EQ(window.GetBucket(i), 0);
+
+		// bucket edges: under 25, 50, 100, 200 and 400 ms, then everything slower
+		for (uint32_t rtt : { 0u, 24999u, 25000u, 99999u, 100000u, 399999u, 400000u, LatencyWindow<8>::Lost })
+			window.AddReply(rtt);
+		CHECK_EQ(window.GetBucket(0), 2);
+		CHECK_EQ(window.GetBucket(1), 1);
+		CHECK_EQ(window.GetBucket(2), 1);
+		CHECK_EQ(window.GetBucket(3), 1);
+		CHECK_EQ(window.GetBucket(4), 1);
+		CHECK_EQ(window.GetBucket(5), 2);
+
+		// replies rolling out leave their bucket, losses never had one
+		window.AddLoss();
+		window.AddLoss();
+		CHECK_EQ(window.GetBucket(0), 0);
+		window.AddReply(30000);
+		CHECK_EQ(window.GetBucket(1), 1);
+		CHECK_EQ(window.GetBucket(1) + window.GetBucket(2) + window.GetBucket(3) + window.GetBucket(4) + window.GetBucket(5),
+			window.GetReplyCount());
+
+		window.Clear();
+		for (size_t i = 0; i < LatencyWindow<8>::BucketCount; i++)
+			CHECK_EQ(window.GetBucket(i), 0);
+	}
+
+	void TestJitter()
+	{
+		LatencyWindow<16> window;
+		window.AddReply(10000);
+		CHECK_EQ(window.GetJitter(), 0);
+
+		// J += (|D| - J) / 16
+		window.AddReply(20000);
+		CHECK_EQ(window.GetJitter(), 625);
+		window.AddReply(10000);
+		CHECK_EQ(window.GetJitter(), 625 + (10000 - 625) / 16);
+
+		// a steady path decays the estimate back towards 0
+		for (int i = 0; i < 200; i++)
+			window.AddReply(10000);
+		CHECK(window.GetJitter() < 16);
+
+		// a loss between two replies doesn't reset the estimate, the difference spans it
+		LatencyWindow<16> gap;
+		gap.AddReply(10000);
+		gap.AddLoss();
+		gap.AddReply(26000);
+		CHECK_EQ(gap.GetJitter(), 1000);
+
+		// Clear() starts over, the next reply has nothing to be compared against
+		gap.Clear();
+		CHECK_EQ(gap.GetCount(), 0);
+		CHECK_EQ(gap.GetJitter(), 0);
+		gap.AddReply(50000);
+		CHECK_EQ(gap.GetJitter(), 0);
+		gap.AddReply(50000 + 1600);
+		CHECK_EQ(gap.GetJitter(), 100);
+	}
+}
+
+int main()
+{
+	TestMedian();
+	TestRolling();
+	TestLoss();
+	TestHistogram();
+	TestJitter();
+	return check::Result();
+}
@@ -0,0 +1,181 @@
+// NetworkWatcher against a stand-in netctl: scripted connect, disconnect and new-IP sequences, once through
+// the registered handler and once through the polled state word, checking when the serial moves.
+
+#include <initializer_list>
+
+#include "check.hpp"
+#include "Utils/NetworkWatcher.hpp"
+
+namespace
+{
+	// the three netctl calls the watcher makes, with a state machine behind them that the tests script
+	struct StandInNetCtl
+	{
+		NetworkWatcher::Handler handler;
+		void* arg;
+		int handlerId;
+		bool refuseHandler;
+		bool failGetState;
+		int state;
+		int addCalls, delCalls, getStateCalls;
+
+		// moves to `newState` and tells the handler, the way netctl reports a transition
+		void Transition(int newState, int event)
+		{
+			int prevState = state;
+			state = newState;
+			if (handler)
+				handler(prevState, newState, event, 0, arg);
+		}
+	};
+
+	StandInNetCtl g_netctl;
+
+	int AddHandler(NetworkWatcher::Handler handler, void* arg, int* handlerId)
+	{
+		g_netctl.addCalls++;
+		if (g_netctl.refuseHandler)
+			return -1;
+		g_netctl.handler = handler;
+		g_netctl.arg = arg;
+		*handlerId = g_netctl.handlerId = 3;
+		return 0;
+	}
+
+	int DelHandler(int handlerId)
+	{
+		g_netctl.delCalls++;
+		CHECK_EQ(handlerId, g_netctl.handlerId);
+		g_netctl.handler = nullptr;
+		return 0;
+	}
+
+	int GetState(int* state)
+	{
+		g_netctl.getStateCalls++;
+		if (g_netctl.failGetState)
+			return -1;
+		*state = g_netctl.state;
+		return 0;
+	}
+
+	void Reset(bool refuseHandler)
+	{
+		g_netctl = StandInNetCtl{};
+		g_netctl.refuseHandler = refuseHandler;
+		g_netctl.state = CELL_NET_CTL_STATE_IPObtained;
+	}
+
+	// a full reconnect as netctl reports it: drop, request, handshake, address
+	void Reconnect()
+	{
+		g_netctl.Transition(CELL_NET_CTL_STATE_Disconnected, CELL_NET_CTL_EVENT_LINK_DISCONNECTED);
+		g_netctl.Transition(CELL_NET_CTL_STATE_Connecting, CELL_NET_CTL_EVENT_CONNECT_REQ);
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtaining, CELL_NET_CTL_EVENT_ESTABLISH);
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtained, CELL_NET_CTL_EVENT_GET_IP);
+	}
+
+	void TestHandler()
+	{
+		Reset(false);
+		NetworkWatcher watcher(AddHandler, DelHandler, GetState);
+		CHECK(watcher.Start());
+		CHECK(!watcher.IsPolling());
+		CHECK(watcher.Start());
+		CHECK_EQ(g_netctl.addCalls, 1);
+
+		uint32_t serial = watcher.GetSerial();
+		CHECK(serial != 0);
+
+		// polling is left to the handler
+		watcher.Poll();
+		CHECK_EQ(g_netctl.getStateCalls, 0);
+		CHECK_EQ(watcher.GetSerial(), serial);
+
+		// a connect request and a handshake that don't change the state aren't worth a refresh
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtained, CELL_NET_CTL_EVENT_CONNECT_REQ);
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtained, CELL_NET_CTL_EVENT_ESTABLISH);
+		CHECK_EQ(watcher.GetSerial(), serial);
+
+		// a new address in the same state is
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtained, CELL_NET_CTL_EVENT_GET_IP);
+		CHECK_EQ(watcher.GetSerial(), serial + 1);
+
+		// every step of a reconnect changes the state
+		serial = watcher.GetSerial();
+		Reconnect();
+		CHECK_EQ(watcher.GetSerial(), serial + 4);
+
+		// a requested disconnect and an error count even when netctl reports them without a transition
+		serial = watcher.GetSerial();
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtained, CELL_NET_CTL_EVENT_DISCONNECT_REQ);
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtained, CELL_NET_CTL_EVENT_ERROR);
+		CHECK_EQ(watcher.GetSerial(), serial + 2);
+
+		// an auth timeout only counts when it drops the connection
+		serial = watcher.GetSerial();
+		g_netctl.Transition(CELL_NET_CTL_STATE_IPObtained, CELL_NET_CTL_EVENT_AUTH_TIMEOUT);
+		CHECK_EQ(watcher.GetSerial(), serial);
+		g_netctl.Transition(CELL_NET_CTL_STATE_Disconnected, CELL_NET_CTL_EVENT_AUTH_TIMEOUT);
+		CHECK_EQ(watcher.GetSerial(), serial + 1);
+
+		watcher.Stop();
+		CHECK_EQ(g_netctl.delCalls, 1);
+		CHECK(watcher.IsPolling());
+		watcher.Stop();
+		CHECK_EQ(g_netctl.delCalls, 1);
+	}
+
+	void TestPolling()
+	{
+		Reset(true);
+		NetworkWatcher watcher(AddHandler, DelHandler, GetState);
+		CHECK(!watcher.Start());
+		CHECK(watcher.IsPolling());
+
+		// the first poll always registers as a change, the state was unknown
+		uint32_t serial = watcher.GetSerial();
+		watcher.Poll();
+		CHECK_EQ(watcher.GetSerial(), serial + 1);
+		watcher.Poll();
+		watcher.Poll();
+		CHECK_EQ(watcher.GetSerial(), serial + 1);
+		CHECK_EQ(g_netctl.getStateCalls, 3);
+
+		// a poll per state sees every step
+		serial = watcher.GetSerial();
+		for (int state : { CELL_NET_CTL_STATE_Disconnected, CELL_NET_CTL_STATE_Connecting, CELL_NET_CTL_STATE_IPObtaining, CELL_NET_CTL_STATE_IPObtained })
+		{
+			g_netctl.Transition(state, CELL_NET_CTL_EVENT_CONNECT_REQ);
+			watcher.Poll();
+		}
+		CHECK_EQ(watcher.GetSerial(), serial + 4);
+
+		// a reconnect completed between two polls leaves the state word where it was: the polled
+		// watcher can't see it, which is why the publisher also refreshes on return from a game
+		serial = watcher.GetSerial();
+		Reconnect();
+		watcher.Poll();
+		CHECK_EQ(watcher.GetSerial(), serial);
+
+		// a failed read is no change
+		g_netctl.failGetState = true;
+		g_netctl.Transition(CELL_NET_CTL_STATE_Disconnected, CELL_NET_CTL_EVENT_LINK_DISCONNECTED);
+		watcher.Poll();
+		CHECK_EQ(watcher.GetSerial(), serial);
+		g_netctl.failGetState = false;
+		watcher.Poll();
+		CHECK_EQ(watcher.GetSerial(), serial + 1);
+
+		// nothing was registered, so nothing to remove
+		watcher.Stop();
+		CHECK_EQ(g_netctl.delCalls, 0);
+	}
+}
+
+int main()
+{
+	TestHandler();
+	TestPolling();
+	return check::Result();
+}
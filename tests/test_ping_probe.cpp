@@ -0,0 +1,246 @@
+// PingProbe against real sockets on the loopback: an echo server that answers the handshake, a closed port
+// that refuses it, and a listener whose queue is full so the handshake never finishes. Then the probe's
+// rate limit, its summaries and what a new target does to them, with the clock passed in.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "check.hpp"
+#include "Utils/PingProbe.hpp"
+
+namespace
+{
+	constexpr uint32_t LOOPBACK = 0x7F000001;
+	constexpr int32_t TIMEOUT_MS = 200;
+	constexpr uint64_t INTERVAL_US = 5 * 1000000ull;
+	constexpr uint64_t START_US = 1000000;
+
+	// a TCP socket bound to an ephemeral loopback port
+	int BindLoopback(uint16_t& port)
+	{
+		int s = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(LOOPBACK);
+		socklen_t length = sizeof(address);
+		if (s < 0 || bind(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+			getsockname(s, reinterpret_cast<sockaddr*>(&address), &length) < 0)
+			return -1;
+		port = ntohs(address.sin_port);
+		return s;
+	}
+
+	// echoes whatever each connection sends until the peer closes it, one connection at a time
+	class EchoServer
+	{
+	public:
+		EchoServer()
+		{
+			m_Socket = BindLoopback(m_Port);
+			if (m_Socket >= 0 && listen(m_Socket, 16) == 0)
+				m_Thread = std::thread([this] { Serve(); });
+		}
+
+		~EchoServer()
+		{
+			m_Stop = true;
+			shutdown(m_Socket, SHUT_RDWR);
+			if (m_Thread.joinable())
+				m_Thread.join();
+			socketclose(m_Socket);
+		}
+
+		bool IsListening() const { return m_Thread.joinable(); }
+		PingTarget Target() const { return PingTarget{ LOOPBACK, m_Port }; }
+
+		// the handshake completes in the kernel, the accept comes after it
+		bool WaitForAccepted(uint32_t count) const
+		{
+			for (int i = 0; i < 1000 && m_Accepted < count; i++)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			return m_Accepted >= count;
+		}
+
+		uint32_t GetAccepted() const { return m_Accepted; }
+
+	private:
+		void Serve()
+		{
+			while (!m_Stop)
+			{
+				int client = accept(m_Socket, nullptr, nullptr);
+				if (client < 0)
+					return;
+				m_Accepted++;
+
+				char buffer[256];
+				ssize_t length;
+				while ((length = recv(client, buffer, sizeof(buffer), 0)) > 0)
+					send(client, buffer, length, 0);
+				socketclose(client);
+			}
+		}
+
+	private:
+		int m_Socket = -1;
+		uint16_t m_Port = 0;
+		std::thread m_Thread;
+		std::atomic<bool> m_Stop{ false };
+		std::atomic<uint32_t> m_Accepted{ 0 };
+	};
+
+	// A listener nobody accepts from, with its queue filled up: the kernel drops further SYNs, the way a
+	// firewall or a dead route does, so a handshake with it only ends at the timeout. Not every host drops
+	// them; IsBlackhole() says whether this one did.
+	class FullListener
+	{
+	public:
+		FullListener()
+		{
+			m_Socket = BindLoopback(m_Port);
+			if (m_Socket < 0 || listen(m_Socket, 0) < 0)
+				return;
+
+			for (int i = 0; i < 8 && !m_IsBlackhole; i++)
+			{
+				int client = socket(AF_INET, SOCK_STREAM, 0);
+				int nonBlocking = 1;
+				setsockopt(client, SOL_SOCKET, SO_NBIO, &nonBlocking, sizeof(nonBlocking));
+				sockaddr_in address{};
+				address.sin_family = AF_INET;
+				address.sin_port = htons(m_Port);
+				address.sin_addr.s_addr = htonl(LOOPBACK);
+				connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+				m_Clients.push_back(client);
+
+				pollfd fd{ client, POLLOUT, 0 };
+				m_IsBlackhole = socketpoll(&fd, 1, 100) == 0;
+			}
+		}
+
+		~FullListener()
+		{
+			for (int client : m_Clients)
+				socketclose(client);
+			socketclose(m_Socket);
+		}
+
+		bool IsBlackhole() const { return m_IsBlackhole; }
+		PingTarget Target() const { return PingTarget{ LOOPBACK, m_Port }; }
+
+	private:
+		int m_Socket = -1;
+		uint16_t m_Port = 0;
+		std::vector<int> m_Clients;
+		bool m_IsBlackhole = false;
+	};
+
+	// a port that was just free, nothing listens on it
+	PingTarget ClosedPort()
+	{
+		uint16_t port = 0;
+		int s = BindLoopback(port);
+		socketclose(s);
+		return PingTarget{ LOOPBACK, port };
+	}
+
+	void TestMeasure()
+	{
+		EchoServer server;
+		CHECK(server.IsListening());
+
+		uint32_t rtt_us = ~0u;
+		CHECK_EQ(MeasureConnectRtt(server.Target(), TIMEOUT_MS, rtt_us), PING_REPLY);
+		CHECK(rtt_us < TIMEOUT_MS * 1000u);
+		CHECK(server.WaitForAccepted(1));
+
+		// a refusal took a round trip as well
+		rtt_us = ~0u;
+		CHECK_EQ(MeasureConnectRtt(ClosedPort(), TIMEOUT_MS, rtt_us), PING_REPLY);
+		CHECK(rtt_us < TIMEOUT_MS * 1000u);
+
+		FullListener full;
+		if (full.IsBlackhole())
+		{
+			CHECK_EQ(MeasureConnectRtt(full.Target(), TIMEOUT_MS, rtt_us), PING_LOST);
+			CHECK(rtt_us >= (TIMEOUT_MS - 10) * 1000u);
+		}
+		else
+			std::printf("test_ping_probe: this host answers a full listen queue, lost handshakes not tested\n");
+	}
+
+	void TestProbe()
+	{
+		EchoServer server;
+		PingProbe probe(INTERVAL_US, TIMEOUT_MS);
+
+		// no target, no probe
+		probe.Run(START_US);
+		CHECK(!probe.GetSummary(server.Target()));
+		CHECK_EQ(server.GetAccepted(), 0);
+
+		probe.SetTarget(PingTarget{ 0, server.Target().port });
+		probe.Run(START_US);
+		CHECK_EQ(probe.GetLatest()->target, 0);
+
+		probe.SetTarget(server.Target());
+		probe.Run(START_US);
+		const PingSummary* summary = probe.GetSummary(server.Target());
+		CHECK(summary != nullptr);
+		if (summary)
+		{
+			CHECK_EQ(summary->target, PingProbe::Pack(server.Target()));
+			CHECK_EQ(summary->replies, 1);
+			CHECK_EQ(summary->lossPercent, 0);
+			CHECK(summary->median_ms < static_cast<uint32_t>(TIMEOUT_MS));
+		}
+		CHECK(server.WaitForAccepted(1));
+
+		// one handshake per interval
+		probe.Run(START_US + INTERVAL_US - 1);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		CHECK_EQ(server.GetAccepted(), 1);
+		probe.Run(START_US + INTERVAL_US);
+		CHECK(server.WaitForAccepted(2));
+
+		// another port on the same address is another target: the next run probes it at once, from an empty
+		// window, and the old target has no summary any more
+		PingTarget closed = ClosedPort();
+		probe.SetTarget(closed);
+		probe.Run(START_US + INTERVAL_US + 1);
+		CHECK(!probe.GetSummary(server.Target()));
+		summary = probe.GetSummary(closed);
+		CHECK(summary != nullptr);
+		if (summary)
+			CHECK_EQ(summary->replies, 1);
+
+		FullListener full;
+		if (!full.IsBlackhole())
+			return;
+
+		// a window of nothing but losses shows as a timeout
+		probe.SetTarget(full.Target());
+		probe.Run(START_US + 2 * INTERVAL_US);
+		summary = probe.GetSummary(full.Target());
+		CHECK(summary != nullptr);
+		if (summary)
+		{
+			CHECK_EQ(summary->replies, 0);
+			CHECK_EQ(summary->lossPercent, 100);
+		}
+	}
+}
+
+int main()
+{
+	TestMeasure();
+	TestProbe();
+	return check::Result();
+}
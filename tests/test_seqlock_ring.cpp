@@ -0,0 +1,102 @@
+// SeqlockRing: ages and wrap-around, and that a concurrent reader gets either an intact entry or false,
+// never a torn one, without waiting on the producer.
+
+#include <atomic>
+#include <thread>
+
+#include "check.hpp"
+#include "Utils/SeqlockRing.hpp"
+
+namespace
+{
+	// every field is the push index, a torn copy has them disagree
+	struct Entry
+	{
+		uint32_t values[16];
+	};
+
+	Entry Make(uint32_t index)
+	{
+		Entry entry{};
+		for (uint32_t& value : entry.values)
+			value = index;
+		return entry;
+	}
+
+	void TestAges()
+	{
+		SeqlockRing<Entry, 8> ring;
+		Entry entry{};
+		CHECK_EQ(ring.GetCount(), 0);
+		CHECK(!ring.Read(0, entry));
+
+		for (uint32_t i = 1; i <= 5; i++)
+			ring.Push(Make(i));
+		CHECK_EQ(ring.GetCount(), 5);
+		CHECK(ring.Read(0, entry));
+		CHECK_EQ(entry.values[0], 5);
+		CHECK(ring.Read(4, entry));
+		CHECK_EQ(entry.values[0], 1);
+		CHECK(!ring.Read(5, entry));
+
+		// past the size, the oldest entries are gone and the ages still count from the newest
+		for (uint32_t i = 6; i <= 20; i++)
+			ring.Push(Make(i));
+		CHECK_EQ(ring.GetWritten(), 20);
+		CHECK_EQ(ring.GetCount(), 8);
+		for (uint32_t age = 0; age < 8; age++)
+		{
+			CHECK(ring.Read(age, entry));
+			CHECK_EQ(entry.values[0], 20 - age);
+		}
+		CHECK(!ring.Read(8, entry));
+	}
+
+	void TestConcurrentRead()
+	{
+		SeqlockRing<Entry, 4> ring;
+		std::atomic<bool> done(false);
+
+		std::thread producer([&] {
+			for (uint32_t index = 1; index <= 200000; index++)
+				ring.Push(Make(index));
+			done = true;
+		});
+
+		// a small ring under a busy producer: plenty of entries get overwritten while being read
+		uint32_t torn = 0, stale = 0, reads = 0, succeeded = 0;
+		while (!done || reads < 1000)
+		{
+			for (uint32_t age = 0; age < 4; age++)
+			{
+				uint32_t written = ring.GetWritten();
+				Entry entry{};
+				reads++;
+				if (!ring.Read(age, entry))
+					continue;
+
+				succeeded++;
+				for (uint32_t value : entry.values)
+					torn += value != entry.values[0];
+				// an entry read at some age was pushed no earlier than that age before the count seen above
+				stale += written > age && entry.values[0] + age < written;
+			}
+		}
+		producer.join();
+
+		CHECK_EQ(torn, 0);
+		CHECK_EQ(stale, 0);
+		CHECK(succeeded > 0);
+
+		Entry entry{};
+		CHECK(ring.Read(3, entry));
+		CHECK_EQ(entry.values[15], 200000 - 3);
+	}
+}
+
+int main()
+{
+	TestAges();
+	TestConcurrentRead();
+	return check::Result();
+}
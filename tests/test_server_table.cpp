@@ -0,0 +1,242 @@
+// ServerTable: address parsing, the line format fed in chunks of any size, lookups, and that entries
+// which don't fit are counted instead of vanishing.
+
+#include <cstring>
+#include <cwchar>
+#include <string>
+
+#include "check.hpp"
+#include "Utils/ServerTable.hpp"
+
+namespace
+{
+	uint32_t Address(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { return (a << 24) | (b << 16) | (c << 8) | d; }
+
+	bool NameIs(const wchar_t* name, const wchar_t* expected) { return name && std::wcscmp(name, expected) == 0; }
+
+	// the plugin's size, the overflow tests only need it small enough to fill
+	ServerTable& FreshTable()
+	{
+		static FixedServerTable<64, 2048> table;
+		table.Clear();
+		return table;
+	}
+
+	void FeedInChunks(ServerTable& table, const std::string& text, size_t chunk)
+	{
+		for (size_t offset = 0; offset < text.size(); offset += chunk)
+			table.Feed(text.data() + offset, text.size() - offset < chunk ? text.size() - offset : chunk);
+		table.Finish();
+	}
+
+	std::string NumberedServers(size_t count)
+	{
+		std::string text;
+		for (size_t i = 0; i < count; i++)
+			text += "10." + std::to_string(i / 256 % 256) + "." + std::to_string(i % 256) + ".1 Server " + std::to_string(i) + "\n";
+		return text;
+	}
+
+	void TestParseIpv4()
+	{
+		uint32_t address = 0;
+		CHECK(ServerTable::ParseIpv4("185.194.142.4", 13, address));
+		CHECK_EQ(address, Address(185, 194, 142, 4));
+
+		// the address ends at whitespace, or at the end of a fixed size field
+		CHECK(ServerTable::ParseIpv4("0.0.0.0 trailing", 16, address));
+		CHECK_EQ(address, 0);
+		char field[16] = "255.255.255.255";
+		CHECK(ServerTable::ParseIpv4(field, sizeof(field), address));
+		CHECK_EQ(address, 0xFFFFFFFFu);
+		CHECK(ServerTable::ParseIpv4("1.2.3.4567", 7, address));
+		CHECK_EQ(address, Address(1, 2, 3, 4));
+
+		address = 42;
+		for (const char* bad : { "", "1.2.3", "1.2.3.4.5", "256.1.1.1", "1..2.3", "1.2.3.", "0001.2.3.4", "1.2.3.4x", "a.b.c.d", " 1.2.3.4" })
+			CHECK(!ServerTable::ParseIpv4(bad, strlen(bad), address));
+		CHECK_EQ(address, 42);
+	}
+
+	void TestParseCidr()
+	{
+		uint32_t network = 0, prefixLength = 0;
+		CHECK(ServerTable::ParseCidr("45.33.44.103", 12, network, prefixLength));
+		CHECK_EQ(network, Address(45, 33, 44, 103));
+		CHECK_EQ(prefixLength, 32);
+
+		// host bits are cleared, the prefix ends at whitespace like the address does
+		CHECK(ServerTable::ParseCidr("45.33.44.103/24 Go Central", 26, network, prefixLength));
+		CHECK_EQ(network, Address(45, 33, 44, 0));
+		CHECK_EQ(prefixLength, 24);
+		CHECK(ServerTable::ParseCidr("10.1.2.3/0", 10, network, prefixLength));
+		CHECK_EQ(network, 0);
+		CHECK_EQ(prefixLength, 0);
+		CHECK(ServerTable::ParseCidr("10.1.2.3/32", 11, network, prefixLength));
+		CHECK_EQ(network, Address(10, 1, 2, 3));
+		CHECK_EQ(prefixLength, 32);
+
+		network = prefixLength = 42;
+		for (const char* bad : { "10.1.2.3/", "10.1.2.3/33", "10.1.2.3/100", "10.1.2.3/2x", "10.1.2/24", "10.1.2.3//24", "/24", "10.1.2.3/-1" })
+			CHECK(!ServerTable::ParseCidr(bad, strlen(bad), network, prefixLength));
+		CHECK_EQ(network, 42);
+		CHECK_EQ(prefixLength, 42);
+	}
+
+	void TestLineFormat()
+	{
+		const std::string text =
+			"# comment line\n"
+			"\n"
+			"185.194.142.4 PlayStation Online Network Emulated\r\n"
+			"51.79.41.185\t\tPlayStation Online Returnal Games  \n"
+			"not.an.address Nope\n"
+			"1.2.3.4\n"
+			"185.194.142.4 Duplicate, the first one wins\n"
+			"209.74.81.0/24 Rocket NET hosts\n"
+			"209.74.81.0/33 Not a range\n"
+			"209.74.81.7 Caf\xC3\xA9 \xE2\x84\xA2";  // no newline at the end, UTF-8 name
+
+		// any chunking gives the same table
+		for (size_t chunk : { size_t(1), size_t(2), size_t(7), size_t(64), text.size() })
+		{
+			ServerTable& table = FreshTable();
+			FeedInChunks(table, text, chunk);
+
+			CHECK_EQ(table.GetCount(), 4);
+			CHECK_EQ(table.GetDroppedCount(), 0);
+			CHECK(NameIs(table.FindByDns(Address(185, 194, 142, 4)), L"PlayStation Online Network Emulated"));
+			CHECK(NameIs(table.FindByDns(Address(51, 79, 41, 185)), L"PlayStation Online Returnal Games"));
+			CHECK(NameIs(table.FindByDns(Address(209, 74, 81, 7)), L"Café ™"));
+			CHECK(!table.FindByDns(Address(1, 2, 3, 4)));
+			CHECK(NameIs(table.FindByRange(Address(209, 74, 81, 7)), L"Café ™"));
+			CHECK(NameIs(table.FindByRange(Address(209, 74, 81, 8)), L"Rocket NET hosts"));
+		}
+	}
+
+	void TestLookups()
+	{
+		ServerTable& table = FreshTable();
+		CHECK(!table.FindByDns(0));
+		CHECK(!table.FindByRange(0));
+
+		// added out of order, looked up sorted
+		CHECK(table.Add(Address(64, 20, 35, 146), L"Home Headquarters"));
+		CHECK(table.Add(Address(45, 33, 44, 103), L"Go Central"));
+		CHECK(table.Add(Address(45, 7, 228, 197), L"Open Spy"));
+		CHECK(!table.Add(Address(45, 33, 44, 103), L"Duplicate"));
+		CHECK_EQ(table.GetCount(), 3);
+		CHECK_EQ(table.GetDroppedCount(), 0);
+
+		CHECK(NameIs(table.FindByDns(Address(45, 33, 44, 103)), L"Go Central"));
+		CHECK(NameIs(table.FindByDns(Address(45, 7, 228, 197)), L"Open Spy"));
+		CHECK(!table.FindByDns(Address(45, 33, 44, 104)));
+
+		// a DNS server only covers its own address, its neighbours need a listed range
+		CHECK(NameIs(table.FindByRange(Address(45, 33, 44, 103)), L"Go Central"));
+		CHECK(!table.FindByRange(Address(64, 20, 35, 1)));
+		CHECK(!table.FindByRange(Address(45, 33, 44, 255)));
+
+		CHECK(table.AddRange(Address(64, 20, 35, 99), 24, L"Home Headquarters"));
+		CHECK(table.AddRange(Address(45, 33, 0, 0), 16, L"Go Central, wide"));
+		CHECK(table.AddRange(Address(45, 33, 44, 96), 27, L"Go Central, game hosts"));
+		CHECK(!table.AddRange(Address(64, 20, 35, 0), 24, L"Duplicate range"));
+		CHECK(!table.AddRange(Address(64, 20, 35, 0), 33, L"Bad prefix"));
+		CHECK_EQ(table.GetCount(), 6);
+
+		CHECK(NameIs(table.FindByRange(Address(64, 20, 35, 1)), L"Home Headquarters"));
+		CHECK(NameIs(table.FindByRange(Address(64, 20, 35, 255)), L"Home Headquarters"));
+		CHECK(!table.FindByRange(Address(64, 20, 36, 146)));
+
+		// the most specific range wins, a DNS server's own address being the most specific of all
+		CHECK(NameIs(table.FindByRange(Address(45, 33, 44, 103)), L"Go Central"));
+		CHECK(NameIs(table.FindByRange(Address(45, 33, 44, 100)), L"Go Central, game hosts"));
+		CHECK(NameIs(table.FindByRange(Address(45, 33, 44, 128)), L"Go Central, wide"));
+		CHECK(NameIs(table.FindByRange(Address(45, 33, 200, 1)), L"Go Central, wide"));
+		CHECK(!table.FindByRange(Address(45, 34, 0, 1)));
+
+		// ranges don't name DNS servers
+		CHECK(!table.FindByDns(Address(64, 20, 35, 0)));
+		CHECK(!table.FindByDns(Address(45, 33, 0, 0)));
+
+		// a /0 holds everything
+		CHECK(table.AddRange(Address(1, 2, 3, 4), 0, L"Anything"));
+		CHECK(NameIs(table.FindByRange(Address(8, 8, 8, 8)), L"Anything"));
+		CHECK(NameIs(table.FindByRange(Address(64, 20, 35, 1)), L"Home Headquarters"));
+	}
+
+	void TestTableOverflow()
+	{
+		const size_t extra = 10;
+		ServerTable& table = FreshTable();
+		FeedInChunks(table, NumberedServers(table.GetMaxServers() + extra), 256);
+
+		CHECK_EQ(table.GetCount(), table.GetMaxServers());
+		CHECK_EQ(table.GetDroppedCount(), extra);
+
+		// the file order decides which ones made it
+		CHECK(NameIs(table.FindByDns(Address(10, 0, 0, 1)), L"Server 0"));
+		size_t last = table.GetMaxServers() - 1;
+		CHECK(NameIs(table.FindByDns(Address(10, last / 256, last % 256, 1)), (L"Server " + std::to_wstring(last)).c_str()));
+		CHECK(!table.FindByDns(Address(10, (last + 1) / 256, (last + 1) % 256, 1)));
+
+		// a known address isn't an overflow
+		CHECK(!table.Add(Address(10, 0, 0, 1), L"again"));
+		CHECK_EQ(table.GetDroppedCount(), extra);
+		CHECK(!table.Add(Address(11, 0, 0, 1), L"no room"));
+		CHECK_EQ(table.GetDroppedCount(), extra + 1);
+
+		table.Clear();
+		CHECK_EQ(table.GetCount(), 0);
+		CHECK_EQ(table.GetDroppedCount(), 0);
+	}
+
+	void TestNamePoolOverflow()
+	{
+		// names long enough that the pool runs out well before the table does
+		ServerTable& table = FreshTable();
+		const size_t nameLength = ServerTable::MaxLineLength - 16;
+		const size_t fits = table.GetNamePoolSize() / (nameLength + 1);
+		CHECK(fits + 5 < table.GetMaxServers());
+		std::string text;
+		for (size_t i = 0; i < fits + 5; i++)
+			text += "10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256) + " " + std::string(nameLength, 'a' + i % 26) + "\n";
+
+		FeedInChunks(table, text, 256);
+		CHECK_EQ(table.GetCount(), fits);
+		CHECK_EQ(table.GetDroppedCount(), 5);
+
+		const wchar_t* name = table.FindByDns(Address(10, 1, 0, 0));
+		CHECK(name && std::wcslen(name) == nameLength && name[0] == L'a');
+	}
+
+	void TestOverlongLine()
+	{
+		// a line longer than the buffer can't be trusted to hold the whole name, it's dropped and counted,
+		// and the lines around it are unaffected
+		std::string text = "1.1.1.1 Before\n";
+		text += "2.2.2.2 " + std::string(ServerTable::MaxLineLength * 3, 'x') + "\n";
+		text += "# " + std::string(ServerTable::MaxLineLength * 2, '#') + "\n";
+		text += "3.3.3.3 After\n";
+
+		ServerTable& table = FreshTable();
+		FeedInChunks(table, text, 100);
+		CHECK_EQ(table.GetCount(), 2);
+		CHECK_EQ(table.GetDroppedCount(), 1);
+		CHECK(NameIs(table.FindByDns(Address(1, 1, 1, 1)), L"Before"));
+		CHECK(NameIs(table.FindByDns(Address(3, 3, 3, 3)), L"After"));
+		CHECK(!table.FindByDns(Address(2, 2, 2, 2)));
+	}
+}
+
+int main()
+{
+	TestParseIpv4();
+	TestParseCidr();
+	TestLineFormat();
+	TestLookups();
+	TestTableOverflow();
+	TestNamePoolOverflow();
+	TestOverlongLine();
+	return check::Result();
+}
@@ -0,0 +1,128 @@
+// Timeline evaluation: holds, eased segments, one-shot end, looping wrap-around, and that evaluating
+// never depends on what was evaluated before.
+
+#include "check.hpp"
+#include "Utils/Timeline.hpp"
+
+namespace
+{
+	// same shape as the plugin's pulse: fade in, hold, fade out, gap
+	constexpr Keyframe PULSE[] =
+	{
+		{ 0, 0.f, nullptr },
+		{ 800, 1.f, Ease::Linear },
+		{ 825, 1.f, nullptr },
+		{ 1625, 0.f, Ease::Linear },
+		{ 2225, 0.f, nullptr },
+	};
+
+	// and the gameboot text: hold, then fade out once
+	constexpr Keyframe GAMEBOOT[] =
+	{
+		{ 0, 1.f, nullptr },
+		{ 3600, 1.f, nullptr },
+		{ 5600, 0.f, Ease::Linear },
+	};
+
+	constexpr Keyframe EASED[] =
+	{
+		{ 0, 0.f, nullptr },
+		{ 100, 1.f, Ease::InQuad },
+	};
+
+	constexpr Timeline PULSE_TIMELINE(PULSE, true);
+	constexpr Timeline GAMEBOOT_TIMELINE(GAMEBOOT, false);
+	constexpr Timeline EASED_TIMELINE(EASED, false);
+
+	constexpr uint64_t START = 1000000;
+
+	void TestOneShot()
+	{
+		CHECK_EQ(GAMEBOOT_TIMELINE.GetDuration(), 5600);
+
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START), 1.f, 1e-6);
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START + 3599), 1.f, 1e-6);
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START + 3600), 1.f, 1e-6);
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START + 4600), 0.5f, 1e-6);
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START + 5100), 0.25f, 1e-6);
+
+		// over: the last key's value, and no segment
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START + 5600), 0.f, 1e-6);
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START + 1000000), 0.f, 1e-6);
+		CHECK_EQ(GAMEBOOT_TIMELINE.GetSegment(START, START + 5600), Timeline::Finished);
+		CHECK_EQ(GAMEBOOT_TIMELINE.GetSegment(START, START + 5599), 2);
+	}
+
+	void TestBeforeStart()
+	{
+		// a `now` behind the start (a clock read on another thread) clamps to the start
+		CHECK_NEAR(GAMEBOOT_TIMELINE.Evaluate(START, START - 500), 1.f, 1e-6);
+		CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START - 500), 0.f, 1e-6);
+		CHECK_EQ(PULSE_TIMELINE.GetSegment(START, 0), 1);
+	}
+
+	void TestSegments()
+	{
+		CHECK_EQ(PULSE_TIMELINE.GetSegment(START, START), 1);
+		CHECK_EQ(PULSE_TIMELINE.GetSegment(START, START + 799), 1);
+		CHECK_EQ(PULSE_TIMELINE.GetSegment(START, START + 800), 2);
+		CHECK_EQ(PULSE_TIMELINE.GetSegment(START, START + 824), 2);
+		CHECK_EQ(PULSE_TIMELINE.GetSegment(START, START + 825), 3);
+		CHECK_EQ(PULSE_TIMELINE.GetSegment(START, START + 1625), 4);
+	}
+
+	void TestLooping()
+	{
+		CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + 400), 0.5f, 1e-6);
+		CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + 812), 1.f, 1e-6);
+		CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + 1225), 0.5f, 1e-6);
+		CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + 2000), 0.f, 1e-6);
+
+		// one period later everything repeats, and the cycle count says how many wraps it took
+		for (uint64_t cycle = 1; cycle < 5; cycle++)
+		{
+			uint64_t offset = cycle * PULSE_TIMELINE.GetDuration();
+			CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + offset), 0.f, 1e-6);
+			CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + offset + 400), 0.5f, 1e-6);
+			CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + offset + 1225), 0.5f, 1e-6);
+
+			uint32_t wraps = 0;
+			CHECK_EQ(PULSE_TIMELINE.GetSegment(START, START + offset + 900, &wraps), 3);
+			CHECK_EQ(wraps, cycle);
+		}
+
+		// far out, where a 32-bit offset would have overflowed
+		uint64_t far = 5000000000ull * PULSE_TIMELINE.GetDuration();
+		CHECK_NEAR(PULSE_TIMELINE.Evaluate(START, START + far + 400), 0.5f, 1e-6);
+	}
+
+	void TestEasing()
+	{
+		CHECK_NEAR(EASED_TIMELINE.Evaluate(0, 50), 0.25f, 1e-6);
+		CHECK_NEAR(EASED_TIMELINE.Evaluate(0, 10), 0.01f, 1e-6);
+		CHECK_NEAR(EASED_TIMELINE.Evaluate(0, 100), 1.f, 1e-6);
+	}
+
+	void TestPure()
+	{
+		// the same (start, now) gives the same value whatever was evaluated in between, in any order
+		float first = PULSE_TIMELINE.Evaluate(START, START + 1337);
+		for (uint64_t now = START; now < START + 3 * PULSE_TIMELINE.GetDuration(); now += 97)
+			PULSE_TIMELINE.Evaluate(START, now);
+		CHECK_EQ(PULSE_TIMELINE.Evaluate(START, START + 1337) == first, true);
+
+		// and no reset is needed for a new start
+		CHECK_NEAR(PULSE_TIMELINE.Evaluate(START + 50, START + 450), 0.5f, 1e-6);
+	}
+}
+
+int main()
+{
+	TestOneShot();
+	TestBeforeStart();
+	TestSegments();
+	TestLooping();
+	TestEasing();
+	TestPure();
+	return check::Result();
+}
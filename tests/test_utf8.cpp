@@ -0,0 +1,268 @@
+// Utf8::Decode: malformed input (overlong forms, surrogates, out of range and stray bytes), truncation
+// by the destination and by the source, and the ASCII fast path against every alignment and every
+// position of the byte that ends it.
+// Only the portable eight-bytes-at-a-time path builds here; the AltiVec one needs the PPU.
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "Utils/Utf8.hpp"
+
+namespace
+{
+	constexpr wchar_t REPLACEMENT = 0xFFFD;
+
+	struct Decoded
+	{
+		std::wstring text;
+		Utf8::DecodeResult result;
+	};
+
+	Decoded Decode(const std::string& source, size_t capacity = 256)
+	{
+		std::vector<wchar_t> destination(capacity + 1, L'#');
+		Decoded decoded;
+		decoded.result = Utf8::Decode(source.data(), source.size(), destination.data(), capacity);
+		if (capacity)
+		{
+			CHECK(destination[decoded.result.written] == L'\0');
+			decoded.text.assign(destination.data(), decoded.result.written);
+		}
+		CHECK(destination[capacity] == L'#');
+		return decoded;
+	}
+
+	std::string Encode(uint32_t codePoint)
+	{
+		std::string out;
+		if (codePoint < 0x80)
+			out += static_cast<char>(codePoint);
+		else if (codePoint < 0x800)
+		{
+			out += static_cast<char>(0xC0 | (codePoint >> 6));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			out += static_cast<char>(0xE0 | (codePoint >> 12));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			out += static_cast<char>(0xF0 | (codePoint >> 18));
+			out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		return out;
+	}
+
+	void TestValid()
+	{
+		Decoded decoded = Decode("IP \xC2\xB1 \xE2\x84\xA2 \xE2\x80\xA6 \xF0\x9F\x8E\xAE");
+		CHECK(decoded.text == L"IP ± ™ … \U0001F3AE");
+		CHECK(!decoded.result.invalid);
+		CHECK(!decoded.result.truncated);
+
+		// the boundaries of every sequence length
+		for (uint32_t codePoint : { 0x0u, 0x7Fu, 0x80u, 0x7FFu, 0x800u, 0xD7FFu, 0xE000u, 0xFFFDu, 0xFFFFu, 0x10000u, 0x10FFFFu })
+		{
+			std::string encoded = Encode(codePoint);
+			decoded = Decode(encoded);
+			CHECK_EQ(decoded.result.read, encoded.size());
+			CHECK(!decoded.result.invalid);
+			CHECK(decoded.text.size() == 1 && static_cast<uint32_t>(decoded.text[0]) == codePoint);
+		}
+
+		decoded = Decode("");
+		CHECK(decoded.text.empty());
+		CHECK(!decoded.result.truncated && !decoded.result.invalid);
+	}
+
+	void TestMalformed()
+	{
+		struct Case
+		{
+			const char* source;
+			const wchar_t* expected;
+		};
+
+		const Case cases[] =
+		{
+			// overlong forms: C0 and C1 can't lead at all, E0 and F0 decode below their minimum
+			{ "\xC0\x80", L"\xFFFD\xFFFD" },
+			{ "\xC1\xBF", L"\xFFFD\xFFFD" },
+			{ "\xE0\x80\x80", L"\xFFFD" },
+			{ "\xE0\x9F\xBF", L"\xFFFD" },
+			{ "\xF0\x80\x80\x80", L"\xFFFD" },
+			{ "\xF0\x8F\xBF\xBF", L"\xFFFD" },
+			// UTF-16 surrogates encoded as UTF-8
+			{ "\xED\xA0\x80", L"\xFFFD" },
+			{ "\xED\xBF\xBF", L"\xFFFD" },
+			{ "a\xED\xB0\x80z", L"a\xFFFDz" },
+			// past U+10FFFF, and leads that could only start such a sequence
+			{ "\xF4\x90\x80\x80", L"\xFFFD" },
+			{ "\xF5\x80\x80\x80", L"\xFFFD\xFFFD\xFFFD\xFFFD" },
+			{ "\xFF", L"\xFFFD" },
+			// a stray continuation, and a sequence cut short by the next character, which survives
+			{ "\x80", L"\xFFFD" },
+			{ "a\xC3(b", L"a\xFFFD(b" },
+			{ "\xE2\x84z", L"\xFFFDz" },
+			{ "\xF0\x9F\x8E\xC3\xA9", L"\xFFFD\xE9" },
+		};
+
+		for (const Case& test : cases)
+		{
+			Decoded decoded = Decode(test.source);
+			if (decoded.text != test.expected)
+				std::fprintf(stderr, "malformed case %zu decoded wrong\n", static_cast<size_t>(&test - cases));
+			CHECK(decoded.text == test.expected);
+			CHECK(decoded.result.invalid);
+			CHECK(!decoded.result.truncated);
+			CHECK_EQ(decoded.result.read, std::strlen(test.source));
+		}
+	}
+
+	void TestTruncation()
+	{
+		// the destination fills up: the terminator always fits
+		Decoded decoded = Decode("hello", 3);
+		CHECK(decoded.text == L"he");
+		CHECK(decoded.result.truncated);
+		CHECK_EQ(decoded.result.read, 2);
+
+		decoded = Decode("hello", 6);
+		CHECK(decoded.text == L"hello");
+		CHECK(!decoded.result.truncated);
+
+		decoded = Decode("ab\xC3\xA9", 3);
+		CHECK(decoded.text == L"ab");
+		CHECK(decoded.result.truncated);
+		CHECK_EQ(decoded.result.read, 2);
+
+		decoded = Decode("x", 1);
+		CHECK(decoded.text.empty());
+		CHECK(decoded.result.truncated);
+
+		// nothing at all fits, not even the terminator
+		std::vector<wchar_t> none(1, L'#');
+		Utf8::DecodeResult result = Utf8::Decode("x", 1, none.data(), 0);
+		CHECK(result.truncated);
+		CHECK_EQ(result.written, 0);
+		CHECK(none[0] == L'#');
+		result = Utf8::Decode("", 0, none.data(), 0);
+		CHECK(!result.truncated);
+
+		// the source ends inside a sequence: the complete part stays, the partial one is left unread
+		for (const char* partial : { "ok\xC3", "ok\xE2\x84", "ok\xF0\x9F\x8E" })
+		{
+			decoded = Decode(partial);
+			CHECK(decoded.text == L"ok");
+			CHECK(decoded.result.truncated);
+			CHECK(!decoded.result.invalid);
+			CHECK_EQ(decoded.result.read, 2);
+		}
+	}
+
+	void TestAsciiPath()
+	{
+		// every length around the word size, from every source alignment, with the run ended by a
+		// non-ASCII byte at every position, or not at all
+		std::string buffer(64 + 8, '\0');
+		for (size_t offset = 0; offset < 8; offset++)
+		{
+			for (size_t length = 0; length <= 64; length++)
+			{
+				for (size_t stop = 0; stop <= length; stop++)
+				{
+					std::wstring expected;
+					for (size_t i = 0; i < length; i++)
+					{
+						char c = static_cast<char>(0x20 + (i * 7 + offset) % 0x5F);
+						buffer[offset + i] = c;
+						expected += static_cast<wchar_t>(c);
+					}
+					if (stop < length)
+					{
+						// a 2-byte sequence starting at `stop`, or a bad lead in the last position
+						if (stop + 1 < length)
+						{
+							buffer[offset + stop] = '\xC3';
+							buffer[offset + stop + 1] = '\xA9';
+							expected[stop] = L'é';
+							expected.erase(stop + 1, 1);
+						}
+						else
+						{
+							buffer[offset + stop] = '\xFF';
+							expected[stop] = REPLACEMENT;
+						}
+					}
+
+					Decoded decoded = Decode(buffer.substr(offset, length));
+					if (decoded.text != expected)
+					{
+						std::fprintf(stderr, "ASCII path: offset %zu length %zu stop %zu\n", offset, length, stop);
+						CHECK(decoded.text == expected);
+						return;
+					}
+				}
+			}
+		}
+
+		// the destination running out in the middle of a run, at every position
+		std::string ascii(40, 'a');
+		for (size_t capacity = 1; capacity <= ascii.size() + 1; capacity++)
+		{
+			Decoded decoded = Decode(ascii, capacity);
+			CHECK_EQ(decoded.text.size(), capacity - 1);
+			CHECK_EQ(decoded.result.read, capacity - 1);
+			CHECK(decoded.result.truncated == (capacity <= ascii.size()));
+		}
+	}
+
+	void TestRandomRoundTrip()
+	{
+		// any valid text decodes to exactly the code points it was made of
+		std::mt19937 random(21);
+		for (int round = 0; round < 2000; round++)
+		{
+			std::string source;
+			std::wstring expected;
+			size_t count = random() % 40;
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t codePoint;
+				switch (random() % 4)
+				{
+				case 0: codePoint = 0x20 + random() % 0x5F; break;
+				case 1: codePoint = 0x80 + random() % (0x800 - 0x80); break;
+				case 2: do codePoint = 0x800 + random() % (0x10000 - 0x800); while (codePoint >= 0xD800 && codePoint <= 0xDFFF); break;
+				default: codePoint = 0x10000 + random() % (0x110000 - 0x10000); break;
+				}
+				source += Encode(codePoint);
+				expected += static_cast<wchar_t>(codePoint);
+			}
+
+			Decoded decoded = Decode(source, 256);
+			CHECK(decoded.text == expected);
+			CHECK(!decoded.result.invalid);
+			CHECK_EQ(decoded.result.read, source.size());
+		}
+	}
+}
+
+int main()
+{
+	static_assert(sizeof(wchar_t) == 4, "the expected strings assume a 32-bit wchar_t, as on the PPU");
+	TestValid();
+	TestMalformed();
+	TestTruncation();
+	TestAsciiPath();
+	TestRandomRoundTrip();
+	return check::Result();
+}
@@ -0,0 +1,143 @@
+// WidgetRoleCache driven the way pafWidgetDrawThis_Hook drives it, with fake widgets standing in for
+// PhWidget: only the name matters to the cache, the address is the key.
+
+#include <new>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "widget_cache.hpp"
+
+namespace
+{
+	struct FakeWidget
+	{
+		std::string name;
+	};
+
+	uint32_t g_classifyCount;
+
+	// same steps as ResolveWidgetRole() in the plugin
+	WidgetRole Resolve(WidgetRoleCache& cache, const FakeWidget* widget)
+	{
+		const std::string& name = widget->name;
+		WidgetRole role;
+		if (cache.Lookup(widget, name.data(), name.size(), role))
+			return role;
+
+		g_classifyCount++;
+		role = WidgetRoles::Classify(name.data(), name.size());
+		cache.Insert(widget, name.data(), name.size(), role);
+		return role;
+	}
+
+	void TestSteadyStateSkipsClassification()
+	{
+		static WidgetRoleCache cache;
+		std::vector<FakeWidget> widgets(300);
+		for (size_t i = 0; i < widgets.size(); i++)
+			widgets[i].name = "item_icon_" + std::to_string(i);
+		widgets[10].name = "ip_text";
+		widgets[20].name = "pslogo_ring";
+		widgets[30].name = "power_saving_mode_text_glow";
+
+		g_classifyCount = 0;
+		for (const FakeWidget& widget : widgets)
+			Resolve(cache, &widget);
+		CHECK_EQ(g_classifyCount, widgets.size());
+		CHECK_EQ(cache.GetCount(), widgets.size());
+
+		// every later frame is lookups only
+		g_classifyCount = 0;
+		for (int frame = 0; frame < 10; frame++)
+			for (const FakeWidget& widget : widgets)
+				Resolve(cache, &widget);
+		CHECK_EQ(g_classifyCount, 0);
+
+		CHECK_EQ(Resolve(cache, &widgets[10]), ROLE_IP_TEXT);
+		CHECK_EQ(Resolve(cache, &widgets[20]), ROLE_PSLOGO_RING);
+		CHECK_EQ(Resolve(cache, &widgets[30]), ROLE_POWER_SAVING_MODE_TEXT_GLOW);
+		CHECK_EQ(Resolve(cache, &widgets[11]), ROLE_NONE);
+	}
+
+	void TestGenerationDropsEntries()
+	{
+		static WidgetRoleCache cache;
+		FakeWidget logo{ "pslogo" };
+
+		cache.Sync(1);
+		Resolve(cache, &logo);
+		CHECK_EQ(cache.GetCount(), 1);
+
+		// same generation again, nothing dropped
+		cache.Sync(1);
+		WidgetRole role;
+		CHECK(cache.Lookup(&logo, logo.name.data(), logo.name.size(), role));
+
+		// xmb_plugin was re-found, the old pointers can't be trusted
+		cache.Sync(2);
+		CHECK_EQ(cache.GetGeneration(), 2);
+		CHECK_EQ(cache.GetCount(), 0);
+		CHECK(!cache.Lookup(&logo, logo.name.data(), logo.name.size(), role));
+	}
+
+	void TestReusedAddressIsReclassified()
+	{
+		static WidgetRoleCache cache;
+
+		// a widget freed and another one constructed at the same address
+		alignas(FakeWidget) static unsigned char storage[sizeof(FakeWidget)];
+		FakeWidget* first = new (storage) FakeWidget{ "pslogo" };
+		CHECK_EQ(Resolve(cache, first), ROLE_PSLOGO);
+		first->~FakeWidget();
+
+		// same length as "pslogo", only the characters differ
+		FakeWidget* second = new (storage) FakeWidget{ "wave_0" };
+		CHECK_EQ(second->name.size(), 6);
+		CHECK_EQ(Resolve(cache, second), ROLE_NONE);
+		second->~FakeWidget();
+
+		// same length and first character, the last one tells them apart
+		FakeWidget* third = new (storage) FakeWidget{ "balanced_mode_text" };
+		CHECK_EQ(Resolve(cache, third), ROLE_BALANCED_MODE_TEXT);
+		third->~FakeWidget();
+
+		FakeWidget* fourth = new (storage) FakeWidget{ "balanced_mode_icon" };
+		CHECK_EQ(Resolve(cache, fourth), ROLE_NONE);
+		fourth->~FakeWidget();
+
+		// and a different length
+		FakeWidget* fifth = new (storage) FakeWidget{ "pslogo_ring" };
+		CHECK_EQ(Resolve(cache, fifth), ROLE_PSLOGO_RING);
+		fifth->~FakeWidget();
+	}
+
+	void TestFullTableFlushes()
+	{
+		static WidgetRoleCache cache;
+		std::vector<FakeWidget> widgets(WidgetRoleCache::MaxLoad + 10);
+		for (size_t i = 0; i < widgets.size(); i++)
+			widgets[i].name = "w" + std::to_string(i);
+
+		for (const FakeWidget& widget : widgets)
+			Resolve(cache, &widget);
+
+		// filling up started the table over instead of probing forever
+		CHECK(cache.GetCount() <= WidgetRoleCache::MaxLoad);
+		CHECK_EQ(cache.GetCount(), 10);
+
+		WidgetRole role;
+		const FakeWidget& last = widgets.back();
+		CHECK(cache.Lookup(&last, last.name.data(), last.name.size(), role));
+		CHECK_EQ(role, ROLE_NONE);
+	}
+}
+
+int main()
+{
+	TestSteadyStateSkipsClassification();
+	TestGenerationDropsEntries();
+	TestReusedAddressIsReclassified();
+	TestFullTableFlushes();
+	return check::Result();
+}
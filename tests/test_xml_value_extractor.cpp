@@ -0,0 +1,265 @@
+// XmlValueExtractor: element text and attribute values, the markup that has to be skipped (comments,
+// CDATA, declarations, processing instructions), entities, plain text input, truncation, and that the
+// result doesn't depend on how the input is chunked. The files under data/xmb are run too.
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "Utils/XmlValueExtractor.hpp"
+
+namespace
+{
+	struct Extracted
+	{
+		std::string value;
+		bool found;
+		bool truncated;
+		bool markup;
+		bool fedAll;   // Feed() never asked to stop
+	};
+
+	Extracted Extract(const std::string& input, const char* element, const char* attribute = nullptr, size_t capacity = 256, size_t chunk = 0)
+	{
+		std::vector<char> output(capacity + 1, '#');
+		XmlValueExtractor extractor(element, attribute, output.data(), capacity);
+
+		Extracted extracted{};
+		extracted.fedAll = true;
+		if (chunk == 0)
+			chunk = input.size() ? input.size() : 1;
+		for (size_t offset = 0; offset < input.size() && extracted.fedAll; offset += chunk)
+			extracted.fedAll = extractor.Feed(input.data() + offset, input.size() - offset < chunk ? input.size() - offset : chunk);
+		extractor.Finish();
+
+		CHECK(output[capacity] == '#');
+		if (capacity)
+		{
+			CHECK_EQ(std::strlen(output.data()), extractor.GetLength());
+			extracted.value.assign(output.data(), extractor.GetLength());
+		}
+		extracted.found = extractor.IsFound();
+		extracted.truncated = extractor.IsTruncated();
+		extracted.markup = extractor.HasMarkup();
+		return extracted;
+	}
+
+	bool ReadFile(const std::string& path, std::string& contents)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		contents = buffer.str();
+		return true;
+	}
+
+	void TestElement()
+	{
+		Extracted extracted = Extract("<a><header>  Hello  </header></a>", "header");
+		CHECK(extracted.found && extracted.markup);
+		CHECK(extracted.value == "Hello");
+
+		// the first occurrence wins and the rest of the input isn't needed
+		extracted = Extract("<a><header>one</header><header>two</header></a>", "header");
+		CHECK(extracted.value == "one");
+		CHECK(!extracted.fedAll);
+
+		// nested markup inside the target is skipped, its text kept
+		extracted = Extract("<header>PS3 <b>Pro</b> <i/>!</header>", "header");
+		CHECK(extracted.value == "PS3 Pro !");
+
+		// a nested element of the same name doesn't end the target early
+		extracted = Extract("<header>a<header>b</header>c</header>", "header");
+		CHECK(extracted.value == "abc");
+
+		// names have to match exactly
+		extracted = Extract("<headers>no</headers><head>no</head><header>yes</header>", "header");
+		CHECK(extracted.value == "yes");
+
+		// a self-closing target is found and empty, a missing one isn't found
+		extracted = Extract("<a><header/></a>", "header");
+		CHECK(extracted.found && extracted.value.empty());
+		extracted = Extract("<a><b>text</b></a>", "header");
+		CHECK(!extracted.found && extracted.value.empty());
+
+		// an element left open at the end keeps what it had
+		extracted = Extract("<a><header>unterminated", "header");
+		CHECK(extracted.found);
+		CHECK(extracted.value == "unterminated");
+
+		// names longer than the buffer never match, even if their start does
+		std::string longName(XmlValueExtractor::MaxNameLength + 10, 'h');
+		extracted = Extract("<" + longName + ">no</" + longName + "><hh>yes</hh>", "hh");
+		CHECK(extracted.value == "yes");
+	}
+
+	void TestAttribute()
+	{
+		Extracted extracted = Extract("<a><header id=\"x\" text='Hello &amp; bye' /></a>", "header", "text");
+		CHECK(extracted.found);
+		CHECK(extracted.value == "Hello & bye");
+
+		// the attribute of another element, or another attribute, doesn't count
+		extracted = Extract("<other text=\"no\"/><header texts=\"no\" text = \"yes\">body</header>", "header", "text");
+		CHECK(extracted.value == "yes");
+
+		// quotes of the other kind belong to the value
+		extracted = Extract("<header text=\"it's\"/>", "header", "text");
+		CHECK(extracted.value == "it's");
+
+		extracted = Extract("<header other=\"x\">body</header>", "header", "text");
+		CHECK(!extracted.found);
+	}
+
+	void TestSkippedMarkup()
+	{
+		const char* input =
+			"<?xml version=\"1.0\"?>"
+			"<!DOCTYPE x [ <!ENTITY e \"<header>doctype</header>\"> ]>"
+			"<!-- <header>comment</header> -- still a comment -->"
+			"<?pi <header>instruction</header> ?>"
+			"<x><header><![CDATA[a <b> & ]] ]]]]></header></x>";
+		Extracted extracted = Extract(input, "header");
+		CHECK(extracted.value == "a <b> & ]] ]]");
+
+		// CDATA outside the target is skipped whole
+		extracted = Extract("<![CDATA[<header>no</header>]]><header>yes</header>", "header");
+		CHECK(extracted.value == "yes");
+	}
+
+	void TestEntities()
+	{
+		Extracted extracted = Extract("<h>&lt;&gt;&amp;&quot;&apos; &#65;&#x42;&#X43; &#x2122; &#x1F3AE;</h>", "h");
+		CHECK(extracted.value == "<>&\"' ABC \xE2\x84\xA2 \xF0\x9F\x8E\xAE");
+
+		// NUL and surrogates become U+FFFD, a number past U+10FFFF isn't a reference at all
+		extracted = Extract("<h>&#0;&#xD800;&#x110000;</h>", "h");
+		CHECK(extracted.value == "\xEF\xBF\xBD\xEF\xBF\xBD&#x110000;");
+
+		// unknown or malformed references stay as written
+		extracted = Extract("<h>&nbsp; &#; &#x; &#12a; AT&T &amp</h>", "h");
+		CHECK(extracted.value == "&nbsp; &#; &#x; &#12a; AT&T &amp");
+
+		// an ampersand that runs into the closing quote, or into markup
+		extracted = Extract("<h v=\"a&b\">x&<i/>y</h>", "h", "v");
+		CHECK(extracted.value == "a&b");
+		extracted = Extract("<h>x&<i/>y</h>", "h");
+		CHECK(extracted.value == "x&y");
+	}
+
+	void TestPlainText()
+	{
+		// no markup at all: the input is the value, with a BOM and surrounding blanks dropped
+		Extracted extracted = Extract("\xEF\xBB\xBF \r\n PS3 Pro header \r\n", "header");
+		CHECK(extracted.found && !extracted.markup);
+		CHECK(extracted.value == "PS3 Pro header");
+
+		// markup after a BOM and blanks is still markup
+		extracted = Extract("\xEF\xBB\xBF\n  <header>x</header>", "header");
+		CHECK(extracted.markup);
+		CHECK(extracted.value == "x");
+
+		// plain text may contain what looks like markup later on
+		extracted = Extract("a < b", "header");
+		CHECK(!extracted.markup);
+		CHECK(extracted.value == "a < b");
+
+		extracted = Extract("", "header");
+		CHECK(!extracted.found);
+	}
+
+	void TestTruncation()
+	{
+		Extracted extracted = Extract("<h>0123456789</h>", "h", nullptr, 5);
+		CHECK(extracted.found && extracted.truncated);
+		CHECK(extracted.value == "0123");
+		CHECK(!extracted.fedAll);
+
+		extracted = Extract("<h>0123</h>", "h", nullptr, 5);
+		CHECK(!extracted.truncated);
+		CHECK(extracted.value == "0123");
+
+		extracted = Extract("plain text", "h", nullptr, 6);
+		CHECK(extracted.truncated);
+		CHECK(extracted.value == "plain");
+
+		// a multi-byte entity that doesn't fit stops the value, it's for the decoder to trim
+		extracted = Extract("<h>ab&#x2122;</h>", "h", nullptr, 4);
+		CHECK(extracted.truncated);
+		CHECK_EQ(extracted.value.size(), 3);
+	}
+
+	void TestChunking(const std::string& input, const char* element, const char* attribute)
+	{
+		Extracted whole = Extract(input, element, attribute);
+		for (size_t chunk : { size_t(1), size_t(2), size_t(3), size_t(7), size_t(64), size_t(256) })
+		{
+			Extracted chunked = Extract(input, element, attribute, 256, chunk);
+			CHECK(chunked.value == whole.value);
+			CHECK(chunked.found == whole.found);
+			CHECK(chunked.truncated == whole.truncated);
+		}
+	}
+
+	void TestCorpus()
+	{
+		struct File
+		{
+			const char* name;
+			bool found;
+			const char* header;
+		};
+
+		const File files[] =
+		{
+			{ "pro.xml", true, "PS3\xE2\x84\xA2 Pro & Friends" },
+			{ "pro_cdata.xml", true, "PS3 Pro <Custom> ]]] & more" },
+			{ "pro_plain.xml", true, "PS3\xE2\x84\xA2 Pro \xE2\x80\x94 System Watcher" },
+			{ "pro_missing.xml", false, "" },
+			{ "category_network.xml", false, "" },
+		};
+
+		for (const File& file : files)
+		{
+			std::string contents;
+			if (!ReadFile(std::string(XMB_CORPUS_DIR) + "/" + file.name, contents))
+			{
+				std::fprintf(stderr, "can't read %s\n", file.name);
+				CHECK(false);
+				continue;
+			}
+
+			Extracted extracted = Extract(contents, "ip_text_header");
+			if (extracted.found != file.found || extracted.value != file.header)
+				std::fprintf(stderr, "%s: got \"%s\"\n", file.name, extracted.value.c_str());
+			CHECK(extracted.found == file.found);
+			CHECK(extracted.value == file.header);
+			TestChunking(contents, "ip_text_header", nullptr);
+		}
+
+		// something that is in the big one
+		std::string contents;
+		CHECK(ReadFile(std::string(XMB_CORPUS_DIR) + "/category_network.xml", contents));
+		Extracted extracted = Extract(contents, "Query", "src");
+		CHECK(extracted.value == "xmb://localhost/dev_flash/vsh/resource/explore/xmb/category_network.xml#seg_network_1");
+	}
+}
+
+int main()
+{
+	TestElement();
+	TestAttribute();
+	TestSkippedMarkup();
+	TestEntities();
+	TestPlainText();
+	TestTruncation();
+	TestChunking("<?x?><!--c--><a b='1'><h k=\"&lt;v&gt;\">&#x2122; <![CDATA[]]]]></h></a>", "h", nullptr);
+	TestChunking("<?x?><!--c--><a b='1'><h k=\"&lt;v&gt;\">&#x2122; <![CDATA[]]]]></h></a>", "h", "k");
+	TestCorpus();
+	return check::Result();
+}